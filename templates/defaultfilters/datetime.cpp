@@ -23,6 +23,284 @@
 #include "util.h"
 
 #include <QtCore/QDateTime>
+#include <QtCore/QLocale>
+#include <QtCore/QPair>
+#include <QtCore/QReadWriteLock>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QVector>
+
+namespace
+{
+
+/**
+  A format string of QDateTime::toString, parsed once.
+
+  Only numeric fields and day and month names are supported. The names are
+  read from QDateTime::toString itself, in the locale it uses then, and a
+  format is only valid if it reproduces QDateTime::toString for a few sample
+  dates.
+*/
+class DateTimeFormat
+{
+public:
+  explicit DateTimeFormat(const QString &format);
+
+  bool isValid() const { return m_valid; }
+
+  QString toString(const QDateTime &dateTime) const;
+
+private:
+  enum Field {
+    Literal,
+    Day,
+    Day2,
+    DayName,
+    LongDayName,
+    Month,
+    Month2,
+    MonthName,
+    LongMonthName,
+    Year2,
+    Year4,
+    Hour,
+    Hour2,
+    Minute,
+    Minute2,
+    Second,
+    Second2,
+    Millisecond3
+  };
+
+  struct Segment {
+    Field field;
+    QString text;
+  };
+
+  QVector<Segment> m_segments;
+  QString m_dayNames[7];
+  QString m_longDayNames[7];
+  QString m_monthNames[12];
+  QString m_longMonthNames[12];
+  bool m_valid;
+};
+
+DateTimeFormat::DateTimeFormat(const QString &format) : m_valid(false)
+{
+  auto usesDayNames = false;
+  auto usesMonthNames = false;
+  QString literal;
+  for (auto i = 0; i < format.size();) {
+    const auto c = format.at(i);
+    if (!c.isLetter() && c != QLatin1Char('\'')) {
+      literal += c;
+      ++i;
+      continue;
+    }
+
+    auto repeat = 1;
+    while (i + repeat < format.size() && format.at(i + repeat) == c)
+      ++repeat;
+    i += repeat;
+
+    Field field;
+    switch (c.unicode()) {
+    case 'd':
+      if (repeat > 4)
+        return;
+      field = static_cast<Field>(Day + repeat - 1);
+      usesDayNames |= repeat > 2;
+      break;
+    case 'M':
+      if (repeat > 4)
+        return;
+      field = static_cast<Field>(Month + repeat - 1);
+      usesMonthNames |= repeat > 2;
+      break;
+    case 'y':
+      if (repeat != 2 && repeat != 4)
+        return;
+      field = repeat == 2 ? Year2 : Year4;
+      break;
+    case 'h':
+    case 'H':
+      if (repeat > 2)
+        return;
+      field = repeat == 1 ? Hour : Hour2;
+      break;
+    case 'm':
+      if (repeat > 2)
+        return;
+      field = repeat == 1 ? Minute : Minute2;
+      break;
+    case 's':
+      if (repeat > 2)
+        return;
+      field = repeat == 1 ? Second : Second2;
+      break;
+    case 'z':
+      if (repeat != 3)
+        return;
+      field = Millisecond3;
+      break;
+    case 'a':
+    case 'A':
+    case 'p':
+    case 'P':
+    case 't':
+    case '\'':
+      // AM/PM markers, time zones and quoted text are left to QDateTime.
+      return;
+    default:
+      // Other letters are copied, as by QDateTime.
+      literal += QString(repeat, c);
+      continue;
+    }
+
+    if (!literal.isEmpty()) {
+      m_segments.push_back({Literal, literal});
+      literal.clear();
+    }
+    m_segments.push_back({field, QString()});
+  }
+  if (!literal.isEmpty())
+    m_segments.push_back({Literal, literal});
+
+  // 2001-01-01 is a Monday.
+  for (auto i = 0; usesDayNames && i < 7; ++i) {
+    const QDateTime day(QDate(2001, 1, 1 + i), QTime(0, 0));
+    m_dayNames[i] = day.toString(QStringLiteral("ddd"));
+    m_longDayNames[i] = day.toString(QStringLiteral("dddd"));
+  }
+  for (auto i = 0; usesMonthNames && i < 12; ++i) {
+    const QDateTime month(QDate(2001, 1 + i, 1), QTime(0, 0));
+    m_monthNames[i] = month.toString(QStringLiteral("MMM"));
+    m_longMonthNames[i] = month.toString(QStringLiteral("MMMM"));
+  }
+
+  m_valid = true;
+  const QDateTime samples[] = {
+      QDateTime(QDate(2001, 2, 3), QTime(4, 5, 6, 789)),
+      QDateTime(QDate(1999, 12, 31), QTime(23, 59, 58, 7)),
+  };
+  for (const auto &sample : samples) {
+    if (toString(sample) != sample.toString(format)) {
+      m_valid = false;
+      return;
+    }
+  }
+}
+
+static void appendNumber(QString *result, int number, int width)
+{
+  ushort digits[4];
+  auto count = 0;
+  do {
+    digits[count++] = ushort('0' + number % 10);
+    number /= 10;
+  } while (number != 0 && count < 4);
+  for (; count < width; ++count)
+    digits[count] = '0';
+  while (count > 0)
+    result->append(QChar(digits[--count]));
+}
+
+QString DateTimeFormat::toString(const QDateTime &dateTime) const
+{
+  const auto date = dateTime.date();
+  const auto time = dateTime.time();
+
+  QString result;
+  for (const auto &segment : m_segments) {
+    switch (segment.field) {
+    case Literal:
+      result += segment.text;
+      break;
+    case Day:
+    case Day2:
+      appendNumber(&result, date.day(), segment.field == Day ? 1 : 2);
+      break;
+    case DayName:
+      result += m_dayNames[date.dayOfWeek() - 1];
+      break;
+    case LongDayName:
+      result += m_longDayNames[date.dayOfWeek() - 1];
+      break;
+    case Month:
+    case Month2:
+      appendNumber(&result, date.month(), segment.field == Month ? 1 : 2);
+      break;
+    case MonthName:
+      result += m_monthNames[date.month() - 1];
+      break;
+    case LongMonthName:
+      result += m_longMonthNames[date.month() - 1];
+      break;
+    case Year2:
+      appendNumber(&result, date.year() % 100, 2);
+      break;
+    case Year4:
+      appendNumber(&result, date.year(), 4);
+      break;
+    case Hour:
+    case Hour2:
+      appendNumber(&result, time.hour(), segment.field == Hour ? 1 : 2);
+      break;
+    case Minute:
+    case Minute2:
+      appendNumber(&result, time.minute(), segment.field == Minute ? 1 : 2);
+      break;
+    case Second:
+    case Second2:
+      appendNumber(&result, time.second(), segment.field == Second ? 1 : 2);
+      break;
+    case Millisecond3:
+      appendNumber(&result, time.msec(), 3);
+      break;
+    }
+  }
+  return result;
+}
+}
+
+static QString formatDateTime(const QDateTime &dateTime, const QString &format)
+{
+  // Years outside of this range are formatted differently by Qt versions.
+  if (!dateTime.isValid() || dateTime.date().year() < 1000
+      || dateTime.date().year() > 9999)
+    return dateTime.toString(format);
+
+  // Filters are shared by all the templates rendered on any thread.
+  static QReadWriteLock lock;
+  static QHash<QPair<QString, QString>, QSharedPointer<const DateTimeFormat>>
+      formats;
+
+  // Qt 5 names days and months in the system locale, which may change while
+  // the application runs. Qt 6 always uses the C locale.
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+  const auto key = qMakePair(QLocale::system().name(), format);
+#else
+  const auto key = qMakePair(QString(), format);
+#endif
+
+  QSharedPointer<const DateTimeFormat> dateTimeFormat;
+  {
+    QReadLocker locker(&lock);
+    dateTimeFormat = formats.value(key);
+  }
+  if (!dateTimeFormat) {
+    dateTimeFormat = QSharedPointer<const DateTimeFormat>::create(format);
+    QWriteLocker locker(&lock);
+    // Formats are usually literals in the templates, but may come from the
+    // context, so the cache is bounded.
+    if (formats.size() >= 256)
+      formats.clear();
+    formats.insert(key, dateTimeFormat);
+  }
+
+  if (!dateTimeFormat->isValid())
+    return dateTime.toString(format);
+  return dateTimeFormat->toString(dateTime);
+}
 
 QVariant timeSince(const QDateTime &early, const QDateTime &late)
 {
@@ -108,9 +386,9 @@ QVariant DateFilter::doFilter(const QVariant &input, const QVariant &argument,
   auto argString = getSafeString(argument);
 
   if (!argString.get().isEmpty())
-    return d.toString(argString);
+    return formatDateTime(d, argString.get());
 
-  return d.toString(QStringLiteral("MMM. d, yyyy"));
+  return formatDateTime(d, QStringLiteral("MMM. d, yyyy"));
 }
 
 QVariant TimeFilter::doFilter(const QVariant &input, const QVariant &argument,
@@ -135,7 +413,7 @@ QVariant TimeFilter::doFilter(const QVariant &input, const QVariant &argument,
   }
 
   auto argString = getSafeString(argument);
-  return d.toString(argString);
+  return formatDateTime(d, argString.get());
 }
 
 QVariant TimeSinceFilter::doFilter(const QVariant &input,
@@ -21,6 +21,7 @@
 #include "lists.h"
 
 #include "metatype.h"
+#include "sequenceview_p.h"
 #include "util.h"
 #include "variable.h"
 
@@ -28,39 +29,60 @@
 #include <QtCore/QRandomGenerator>
 #endif
 #include <QtCore/QDateTime>
-#include <QtCore/QSequentialIterable>
 
 QVariant JoinFilter::doFilter(const QVariant &input, const QVariant &argument,
                               bool autoescape) const
 {
-  if (!input.canConvert<QVariantList>())
+  const SequenceView iter(input);
+  if (!iter.isValid())
     return {};
 
-  auto iter = input.value<QSequentialIterable>();
-
   QString ret;
-  for (auto it = iter.begin(); it != iter.end(); ++it) {
-    const auto var = *it;
-    auto s = getSafeString(var);
+  const auto separator = conditionalEscape(getSafeString(argument));
+  const auto begin = iter.begin();
+  const auto end = iter.end();
+  for (auto it = begin; it != end; ++it) {
+    if (it != begin)
+      ret.append(separator);
+    auto s = getSafeString(*it);
     if (autoescape)
       s = conditionalEscape(s);
 
     ret.append(s);
-    if ((it + 1) != iter.end()) {
-      auto argString = getSafeString(argument);
-      ret.append(conditionalEscape(argString));
-    }
   }
   return markSafe(ret);
 }
 
+void JoinFilter::doFilterToStream(const QVariant &input,
+                                  const QVariant &argument,
+                                  OutputStream &stream, bool autoescape) const
+{
+  const SequenceView iter(input);
+  if (!iter.isValid())
+    return;
+
+  // The items are written as they are joined, as the result is safe.
+  const auto separator = conditionalEscape(getSafeString(argument));
+  const auto begin = iter.begin();
+  const auto end = iter.end();
+  for (auto it = begin; it != end; ++it) {
+    if (it != begin)
+      stream << separator.get();
+    auto s = getSafeString(*it);
+    if (autoescape)
+      s = conditionalEscape(s);
+    stream << s.get();
+  }
+}
+
 QVariant LengthFilter::doFilter(const QVariant &input, const QVariant &argument,
                                 bool autoescape) const
 {
   Q_UNUSED(autoescape)
   Q_UNUSED(argument)
-  if (input.canConvert<QVariantList>())
-    return input.value<QSequentialIterable>().size();
+  const SequenceView iter(input);
+  if (iter.isValid())
+    return iter.size();
 
   if (input.userType() == qMetaTypeId<SafeString>()
       || input.userType() == qMetaTypeId<QString>())
@@ -79,8 +101,9 @@ QVariant LengthIsFilter::doFilter(const QVariant &input,
     return {};
 
   auto size = 0;
-  if (input.canConvert<QVariantList>())
-    size = input.value<QSequentialIterable>().size();
+  const SequenceView iter(input);
+  if (iter.isValid())
+    size = iter.size();
   else if (input.userType() == qMetaTypeId<SafeString>()
            || input.userType() == qMetaTypeId<QString>())
     size = getSafeString(input).get().size();
@@ -100,12 +123,11 @@ QVariant FirstFilter::doFilter(const QVariant &input, const QVariant &argument,
   Q_UNUSED(autoescape)
   Q_UNUSED(argument)
 
-  if (!input.canConvert<QVariantList>())
+  const SequenceView iter(input);
+  if (!iter.isValid())
     return {};
 
-  auto iter = input.value<QSequentialIterable>();
-
-  if (iter.size() == 0)
+  if (iter.isEmpty())
     return QString();
 
   return *iter.begin();
@@ -117,12 +139,11 @@ QVariant LastFilter::doFilter(const QVariant &input, const QVariant &argument,
   Q_UNUSED(autoescape)
   Q_UNUSED(argument)
 
-  if (!input.canConvert<QVariantList>())
+  const SequenceView iter(input);
+  if (!iter.isValid())
     return {};
 
-  auto iter = input.value<QSequentialIterable>();
-
-  if (iter.size() == 0)
+  if (iter.isEmpty())
     return QString();
 
   return *(iter.end() - 1);
@@ -134,11 +155,7 @@ QVariant RandomFilter::doFilter(const QVariant &input, const QVariant &argument,
   Q_UNUSED(autoescape)
   Q_UNUSED(argument)
 
-  if (!input.canConvert<QVariantList>())
-    return {};
-
-  auto varList = input.value<QVariantList>();
-
+  const SequenceView varList(input);
   if (varList.isEmpty())
     return {};
 
@@ -217,14 +234,15 @@ QVariant UnorderedListFilter::doFilter(const QVariant &input,
 {
   Q_UNUSED(argument)
 
-  if (!input.canConvert<QVariantList>())
+  const SequenceView list(input);
+  if (!list.isValid())
     return {};
 
-  return markSafe(processList(input.value<QVariantList>(), 1, autoescape));
+  return markSafe(processList(list, 1, autoescape));
 }
 
-SafeString UnorderedListFilter::processList(const QVariantList &list, int tabs,
-                                            bool autoescape) const
+SafeString UnorderedListFilter::processList(const SequenceView &list,
+                                            int tabs, bool autoescape) const
 {
   QString indent;
   for (auto i = 0; i < tabs; ++i)
@@ -250,8 +268,7 @@ SafeString UnorderedListFilter::processList(const QVariantList &list, int tabs,
       ++i;
     }
     if (sublistItem.isValid()) {
-      sublist = processList(sublistItem.value<QVariantList>(), tabs + 1,
-                            autoescape);
+      sublist = processList(SequenceView(sublistItem), tabs + 1, autoescape);
       sublist = QStringLiteral("\n%1<ul>\n%2\n%3</ul>\n%4")
                     .arg(indent, sublist, indent, indent);
     }
@@ -325,20 +342,27 @@ QVariant DictSortFilter::doFilter(const QVariant &input,
 {
   Q_UNUSED(autoescape)
 
-  if (!input.canConvert<QVariantList>())
+  const SequenceView inList(input);
+  if (!inList.isValid())
     return {};
 
+  if (inList.isEmpty())
+    return QVariantList();
+
+  // The argument is parsed once for all items.
+  const Variable v(getSafeString(argument));
+  const auto literal = v.literal();
+  const auto literalKey = literal.value<QString>();
+  const auto lookups = v.lookups();
+
   QList<QPair<QVariant, QVariant>> keyList;
-  const auto inList = input.value<QSequentialIterable>();
+  keyList.reserve(inList.size());
   for (const QVariant &item : inList) {
     auto var = item;
 
-    const Variable v(getSafeString(argument));
-
-    if (v.literal().isValid()) {
-      var = MetaType::lookup(var, v.literal().value<QString>());
+    if (literal.isValid()) {
+      var = MetaType::lookup(var, literalKey);
     } else {
-      const auto lookups = v.lookups();
       for (const QString &lookup : lookups) {
         var = MetaType::lookup(var, lookup);
       }
@@ -350,6 +374,7 @@ QVariant DictSortFilter::doFilter(const QVariant &input,
   std::stable_sort(keyList.begin(), keyList.end(), lt);
 
   QVariantList outList;
+  outList.reserve(keyList.size());
   auto it = keyList.constBegin();
   const auto end = keyList.constEnd();
   for (; it != end; ++it) {
@@ -25,15 +25,23 @@
 
 #include "filter.h"
 
+namespace Grantlee
+{
+class SequenceView;
+}
+
 using namespace Grantlee;
 
-class JoinFilter : public Filter
+class JoinFilter : public Filter, public StreamingFilter
 {
 public:
   QVariant doFilter(const QVariant &input, const QVariant &argument = {},
                     bool autoescape = {}) const override;
 
   bool isSafe() const override { return true; }
+
+  void doFilterToStream(const QVariant &input, const QVariant &argument,
+                        OutputStream &stream, bool autoescape) const override;
 };
 
 class LengthFilter : public Filter
@@ -104,7 +112,7 @@ public:
   bool isSafe() const override { return true; }
 
 protected:
-  SafeString processList(const QVariantList &list, int tabs,
+  SafeString processList(const SequenceView &list, int tabs,
                          bool autoescape) const;
 };
 
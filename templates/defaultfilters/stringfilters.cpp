@@ -24,6 +24,47 @@
 
 #include <QtCore/QRegularExpression>
 #include <QtCore/QVariant>
+#include <QtCore/QVector>
+
+#include <algorithm>
+
+static bool isAsciiDigit(QChar c)
+{
+  return c.unicode() >= '0' && c.unicode() <= '9';
+}
+
+// The characters matched by \w in a QRegularExpression.
+static bool isAsciiWordCharacter(QChar c)
+{
+  const auto u = c.unicode();
+  return (u >= 'a' && u <= 'z') || (u >= 'A' && u <= 'Z')
+         || (u >= '0' && u <= '9') || u == '_';
+}
+
+// The characters matched by \s in a QRegularExpression.
+static bool isAsciiSpace(QChar c)
+{
+  const auto u = c.unicode();
+  return u == ' ' || (u >= '\t' && u <= '\r');
+}
+
+// Returns @p content with the @p safety given, and whether it needs escaping
+// taken from @p original, like the in-place modifications of a SafeString.
+static SafeString withContent(const SafeString &original,
+                              const QString &content, SafeString::Safety safety)
+{
+  SafeString result(content, safety);
+  result.setNeedsEscape(original.needsEscape());
+  return result;
+}
+
+// Leaves @p input as the QString returned by a filter would become: not safe,
+// and not needing escaping.
+static void markAsString(SafeString &input)
+{
+  input.setSafety(SafeString::IsNotSafe);
+  input.setNeedsEscape(false);
+}
 
 QVariant AddSlashesFilter::doFilter(const QVariant &input,
                                     const QVariant &argument,
@@ -41,6 +82,20 @@ QVariant AddSlashesFilter::doFilter(const QVariant &input,
   return safeString;
 }
 
+void AddSlashesFilter::filterInPlace(SafeString &input,
+                                     const QVariant &argument,
+                                     bool autoescape) const
+{
+  Q_UNUSED(argument)
+  Q_UNUSED(autoescape)
+  input.get()
+      .replace(QLatin1Char('\\'), QStringLiteral("\\\\"))
+      .get()
+      .replace(QLatin1Char('\"'), QStringLiteral("\\\""))
+      .get()
+      .replace(QLatin1Char('\''), QStringLiteral("\\\'"));
+}
+
 QVariant CapFirstFilter::doFilter(const QVariant &input,
                                   const QVariant &argument,
                                   bool autoescape) const
@@ -56,54 +111,72 @@ QVariant CapFirstFilter::doFilter(const QVariant &input,
                       safeString.get().right(safeString.get().size() - 1)));
 }
 
+void CapFirstFilter::filterInPlace(SafeString &input,
+                                   const QVariant &argument,
+                                   bool autoescape) const
+{
+  Q_UNUSED(argument)
+  Q_UNUSED(autoescape)
+  QString &content = input.get();
+  if (!content.isEmpty())
+    content[0] = content.at(0).toUpper();
+  markAsString(input);
+}
+
 EscapeJsFilter::EscapeJsFilter() = default;
 
-static QList<QPair<QString, QString>> getJsEscapes()
-{
-  QList<QPair<QString, QString>> jsEscapes;
-  jsEscapes << QPair<QString, QString>(QChar::fromLatin1('\\'),
-                                       QStringLiteral("\\u005C"))
-            << QPair<QString, QString>(QChar::fromLatin1('\''),
-                                       QStringLiteral("\\u0027"))
-            << QPair<QString, QString>(QChar::fromLatin1('\"'),
-                                       QStringLiteral("\\u0022"))
-            << QPair<QString, QString>(QChar::fromLatin1('>'),
-                                       QStringLiteral("\\u003E"))
-            << QPair<QString, QString>(QChar::fromLatin1('<'),
-                                       QStringLiteral("\\u003C"))
-            << QPair<QString, QString>(QChar::fromLatin1('&'),
-                                       QStringLiteral("\\u0026"))
-            << QPair<QString, QString>(QChar::fromLatin1('='),
-                                       QStringLiteral("\\u003D"))
-            << QPair<QString, QString>(QChar::fromLatin1('-'),
-                                       QStringLiteral("\\u002D"))
-            << QPair<QString, QString>(QChar::fromLatin1(';'),
-                                       QStringLiteral("\\u003B"))
-            << QPair<QString, QString>(QChar(0x2028), QStringLiteral("\\u2028"))
-            << QPair<QString, QString>(QChar(0x2029),
-                                       QStringLiteral("\\u2029"));
+static QVector<QString> getJsEscapes()
+{
+  // The escapes of the ASCII characters, indexed by character.
+  QVector<QString> jsEscapes(128);
+  const char escapedCharacters[] = "\\\'\"><&=-;";
+  for (const auto *c = escapedCharacters; *c; ++c)
+    jsEscapes[*c] = QStringLiteral("\\u00")
+                    + QStringLiteral("%1").arg(int(*c), 2, 16).toUpper();
 
   for (auto i = 0; i < 32; ++i) {
-    jsEscapes << QPair<QString, QString>(
-        QChar(i),
-        QStringLiteral("\\u00")
-            + QStringLiteral("%1").arg(i, 2, 16, QLatin1Char('0')).toUpper());
+    jsEscapes[i]
+        = QStringLiteral("\\u00")
+          + QStringLiteral("%1").arg(i, 2, 16, QLatin1Char('0')).toUpper();
   }
   return jsEscapes;
 }
 
+static const auto jsEscapes = getJsEscapes();
+
+static bool needsJsEscape(QChar c)
+{
+  const auto u = c.unicode();
+  return u < 128 ? !jsEscapes.at(u).isEmpty() : u == 0x2028 || u == 0x2029;
+}
+
 QVariant EscapeJsFilter::doFilter(const QVariant &input,
                                   const QVariant &argument,
                                   bool autoescape) const
 {
   Q_UNUSED(argument)
   Q_UNUSED(autoescape)
-  QString retString = getSafeString(input);
+  const QString inputString = getSafeString(input);
 
-  static const auto jsEscapes = getJsEscapes();
+  const auto begin = inputString.constBegin();
+  const auto end = inputString.constEnd();
+  auto it = std::find_if(begin, end, needsJsEscape);
+  if (it == end)
+    return inputString;
 
-  for (auto &escape : jsEscapes) {
-    retString = retString.replace(escape.first, escape.second);
+  QString retString;
+  retString.reserve(inputString.size() + 16);
+  retString.append(begin, int(it - begin));
+  for (; it != end; ++it) {
+    const auto u = it->unicode();
+    if (u < 128 && !jsEscapes.at(u).isEmpty())
+      retString.append(jsEscapes.at(u));
+    else if (u == 0x2028)
+      retString.append(QLatin1String("\\u2028"));
+    else if (u == 0x2029)
+      retString.append(QLatin1String("\\u2029"));
+    else
+      retString.append(*it);
   }
   return retString;
 }
@@ -115,13 +188,42 @@ QVariant FixAmpersandsFilter::doFilter(const QVariant &input,
   Q_UNUSED(argument)
   Q_UNUSED(autoescape)
   auto safeString = getSafeString(input);
+  const QString &inputString = safeString.get();
 
-  const QRegularExpression fixAmpersandsRegexp(
-      QStringLiteral("&(?!(\\w+|#\\d+);)"));
+  // Replaces the ampersands not starting an entity, like the regular
+  // expression "&(?!(\\w+|#\\d+);)" would.
+  auto pos = inputString.indexOf(QLatin1Char('&'));
+  if (pos == -1)
+    return withContent(safeString, inputString, SafeString::IsNotSafe);
 
-  safeString.get().replace(fixAmpersandsRegexp, QStringLiteral("&amp;"));
+  const auto size = inputString.size();
+  QString output;
+  output.reserve(size + 16);
+  auto copied = 0;
+  for (; pos != -1; pos = inputString.indexOf(QLatin1Char('&'), pos + 1)) {
+    auto end = pos + 1;
+    if (end < size && inputString.at(end) == QLatin1Char('#')) {
+      auto digitsEnd = end + 1;
+      while (digitsEnd < size && isAsciiDigit(inputString.at(digitsEnd)))
+        ++digitsEnd;
+      if (digitsEnd > end + 1 && digitsEnd < size
+          && inputString.at(digitsEnd) == QLatin1Char(';'))
+        continue;
+    }
+    while (end < size && isAsciiWordCharacter(inputString.at(end)))
+      ++end;
+    if (end > pos + 1 && end < size && inputString.at(end) == QLatin1Char(';'))
+      continue;
+
+    output.append(inputString.constData() + copied, pos + 1 - copied);
+    output.append(QLatin1String("amp;"));
+    copied = pos + 1;
+  }
+  if (copied == 0)
+    return withContent(safeString, inputString, SafeString::IsNotSafe);
+  output.append(inputString.constData() + copied, size - copied);
 
-  return safeString;
+  return withContent(safeString, output, SafeString::IsNotSafe);
 }
 
 QVariant CutFilter::doFilter(const QVariant &input, const QVariant &argument,
@@ -140,6 +242,19 @@ QVariant CutFilter::doFilter(const QVariant &input, const QVariant &argument,
   return retString;
 }
 
+void CutFilter::filterInPlace(SafeString &input, const QVariant &argument,
+                              bool autoescape) const
+{
+  Q_UNUSED(autoescape)
+  const auto argString = getSafeString(argument);
+  const auto inputSafe = input.isSafe();
+
+  input.get().remove(argString);
+
+  if (inputSafe && argString.get() != QChar::fromLatin1(';'))
+    input.setSafety(SafeString::IsSafe);
+}
+
 QVariant SafeFilter::doFilter(const QVariant &input, const QVariant &argument,
                               bool autoescape) const
 {
@@ -148,6 +263,27 @@ QVariant SafeFilter::doFilter(const QVariant &input, const QVariant &argument,
   return markSafe(getSafeString(input));
 }
 
+void SafeFilter::filterInPlace(SafeString &input, const QVariant &argument,
+                               bool autoescape) const
+{
+  Q_UNUSED(argument)
+  Q_UNUSED(autoescape)
+  input.setSafety(SafeString::IsSafe);
+}
+
+void SafeFilter::doFilterToStream(const QVariant &input,
+                                  const QVariant &argument,
+                                  OutputStream &stream, bool autoescape) const
+{
+  Q_UNUSED(argument)
+  const auto inputString = getSafeString(input);
+  if (escapesResult(this, input, true, inputString.needsEscape(),
+                    autoescape))
+    stream << stream.escape(inputString.get());
+  else
+    stream << inputString.get();
+}
+
 QVariant LineNumbersFilter::doFilter(const QVariant &input,
                                      const QVariant &argument,
                                      bool autoescape) const
@@ -176,6 +312,16 @@ QVariant LowerFilter::doFilter(const QVariant &input, const QVariant &argument,
   return getSafeString(input).get().toLower();
 }
 
+void LowerFilter::filterInPlace(SafeString &input, const QVariant &argument,
+                                bool autoescape) const
+{
+  Q_UNUSED(argument)
+  Q_UNUSED(autoescape)
+  QString &content = input.get();
+  content = content.toLower();
+  markAsString(input);
+}
+
 QVariant StringFormatFilter::doFilter(const QVariant &input,
                                       const QVariant &argument,
                                       bool autoescape) const
@@ -192,14 +338,8 @@ QVariant StringFormatFilter::doFilter(const QVariant &input,
                     getSafeString(input).isSafe());
 }
 
-QVariant TitleFilter::doFilter(const QVariant &input, const QVariant &argument,
-                               bool autoescape) const
+static void toTitleCase(QString &str)
 {
-  Q_UNUSED(argument)
-  Q_UNUSED(autoescape)
-
-  QString str = getSafeString(input);
-
   auto it = str.begin();
   const auto end = str.end();
 
@@ -211,10 +351,28 @@ QVariant TitleFilter::doFilter(const QVariant &input, const QVariant &argument,
       *it = it->toLower();
     toUpper = it->isSpace();
   }
+}
 
+QVariant TitleFilter::doFilter(const QVariant &input, const QVariant &argument,
+                               bool autoescape) const
+{
+  Q_UNUSED(argument)
+  Q_UNUSED(autoescape)
+
+  QString str = getSafeString(input);
+  toTitleCase(str);
   return str;
 }
 
+void TitleFilter::filterInPlace(SafeString &input, const QVariant &argument,
+                                bool autoescape) const
+{
+  Q_UNUSED(argument)
+  Q_UNUSED(autoescape)
+  toTitleCase(input.get());
+  markAsString(input);
+}
+
 QVariant TruncateWordsFilter::doFilter(const QVariant &input,
                                        const QVariant &argument,
                                        bool autoescape) const
@@ -230,21 +388,41 @@ QVariant TruncateWordsFilter::doFilter(const QVariant &input,
   }
 
   QString inputString = getSafeString(input);
-  auto words = inputString.split(QLatin1Char(' '),
-#if QT_VERSION < QT_VERSION_CHECK(5, 14, 0)
-                                 QString::SkipEmptyParts
-#else
-                                 Qt::SkipEmptyParts
-#endif
-  );
 
-  if (words.size() > numWords) {
-    words = words.mid(0, numWords);
-    if (!words.at(words.size() - 1).endsWith(QStringLiteral("..."))) {
-      words << QStringLiteral("...");
+  // The words are separated by single spaces, and followed by an ellipsis if
+  // some are left out.
+  QString output;
+  output.reserve(inputString.size() + 4);
+  const auto size = inputString.size();
+  auto count = 0;
+  auto truncated = false;
+  for (auto pos = 0;;) {
+    while (pos < size && inputString.at(pos) == QLatin1Char(' '))
+      ++pos;
+    if (pos == size)
+      break;
+    if (count == numWords) {
+      truncated = true;
+      break;
     }
+    auto end = inputString.indexOf(QLatin1Char(' '), pos);
+    if (end == -1)
+      end = size;
+    if (count > 0)
+      output.append(QLatin1Char(' '));
+    output.append(inputString.constData() + pos, end - pos);
+    ++count;
+    pos = end;
+  }
+  // A negative number of words keeps all of them, but is always truncated.
+  if (numWords < 0 && count > 0)
+    truncated = true;
+  if (truncated && !output.endsWith(QStringLiteral("..."))) {
+    if (count > 0)
+      output.append(QLatin1Char(' '));
+    output.append(QStringLiteral("..."));
   }
-  return words.join(QChar::fromLatin1(' '));
+  return output;
 }
 
 QVariant UpperFilter::doFilter(const QVariant &input, const QVariant &argument,
@@ -255,6 +433,16 @@ QVariant UpperFilter::doFilter(const QVariant &input, const QVariant &argument,
   return getSafeString(input).get().toUpper();
 }
 
+void UpperFilter::filterInPlace(SafeString &input, const QVariant &argument,
+                                bool autoescape) const
+{
+  Q_UNUSED(argument)
+  Q_UNUSED(autoescape)
+  QString &content = input.get();
+  content = content.toUpper();
+  markAsString(input);
+}
+
 QVariant WordCountFilter::doFilter(const QVariant &input,
                                    const QVariant &argument,
                                    bool autoescape) const
@@ -302,6 +490,30 @@ QVariant EscapeFilter::doFilter(const QVariant &input, const QVariant &argument,
   return markForEscaping(getSafeString(input));
 }
 
+void EscapeFilter::filterInPlace(SafeString &input, const QVariant &argument,
+                                 bool autoescape) const
+{
+  Q_UNUSED(argument)
+  Q_UNUSED(autoescape)
+  if (!input.isSafe())
+    input.setNeedsEscape(true);
+}
+
+void EscapeFilter::doFilterToStream(const QVariant &input,
+                                    const QVariant &argument,
+                                    OutputStream &stream,
+                                    bool autoescape) const
+{
+  Q_UNUSED(argument)
+  const auto inputString = getSafeString(input);
+  const auto inputIsSafe = inputString.isSafe();
+  if (escapesResult(this, input, inputIsSafe,
+                    !inputIsSafe || inputString.needsEscape(), autoescape))
+    stream << stream.escape(inputString.get());
+  else
+    stream << inputString.get();
+}
+
 QVariant ForceEscapeFilter::doFilter(const QVariant &input,
                                      const QVariant &argument,
                                      bool autoescape) const
@@ -311,22 +523,120 @@ QVariant ForceEscapeFilter::doFilter(const QVariant &input,
   return markSafe(escape(getSafeString(input)));
 }
 
+void ForceEscapeFilter::filterInPlace(SafeString &input,
+                                      const QVariant &argument,
+                                      bool autoescape) const
+{
+  Q_UNUSED(argument)
+  Q_UNUSED(autoescape)
+  input = markSafe(escape(input));
+}
+
+void ForceEscapeFilter::doFilterToStream(const QVariant &input,
+                                         const QVariant &argument,
+                                         OutputStream &stream,
+                                         bool autoescape) const
+{
+  Q_UNUSED(argument)
+  Q_UNUSED(autoescape)
+  // The escaped result is safe, so it is never escaped again.
+  stream << escape(getSafeString(input)).get();
+}
+
+/**
+  Returns the length of the start tag, or end tag if @p endTag is true, of
+  one of @p tags at @p pos in @p input, or 0 if there is none.
+*/
+static int tagLength(const QString &input, int pos, const QStringList &tags,
+                     bool endTag)
+{
+  const auto size = input.size();
+  const auto nameStart = pos + (endTag ? 2 : 1);
+  if (endTag && (nameStart > size || input.at(pos + 1) != QLatin1Char('/')))
+    return 0;
+
+  for (const auto &tag : tags) {
+    const auto nameEnd = nameStart + tag.size();
+    if (nameEnd >= size
+        || !std::equal(tag.constBegin(), tag.constEnd(),
+                       input.constBegin() + nameStart))
+      continue;
+    const auto next = input.at(nameEnd);
+    if (next == QLatin1Char('>'))
+      return nameEnd + 1 - pos;
+    if (endTag)
+      continue;
+    if (next == QLatin1Char('/')) {
+      if (nameEnd + 1 < size && input.at(nameEnd + 1) == QLatin1Char('>'))
+        return nameEnd + 2 - pos;
+    } else if (isAsciiSpace(next)) {
+      const auto close = input.indexOf(QLatin1Char('>'), nameEnd + 1);
+      if (close != -1)
+        return close + 1 - pos;
+    }
+  }
+  return 0;
+}
+
+/**
+  Removes the start tags, or end tags if @p endTags is true, of @p tags from
+  @p input, like the regular expressions "<(tags)(/?>|(\\s+[^>]*>))" and
+  "</(tags)>" would.
+*/
+static QString removeTags(const QString &input, const QStringList &tags,
+                          bool endTags)
+{
+  QString output;
+  auto copied = 0;
+  for (auto pos = input.indexOf(QLatin1Char('<')); pos != -1;) {
+    const auto length = tagLength(input, pos, tags, endTags);
+    if (length == 0) {
+      pos = input.indexOf(QLatin1Char('<'), pos + 1);
+      continue;
+    }
+    if (output.isNull())
+      output.reserve(input.size());
+    output.append(input.constData() + copied, pos - copied);
+    copied = pos + length;
+    pos = input.indexOf(QLatin1Char('<'), copied);
+  }
+  if (copied == 0)
+    return input;
+  output.append(input.constData() + copied, input.size() - copied);
+  return output;
+}
+
 QVariant RemoveTagsFilter::doFilter(const QVariant &input,
                                     const QVariant &argument,
                                     bool autoescape) const
 {
   Q_UNUSED(autoescape)
   const auto tags = getSafeString(argument).get().split(QLatin1Char(' '));
-  const auto tagRe
-      = QStringLiteral("(%1)").arg(tags.join(QChar::fromLatin1('|')));
-  const QRegularExpression startTag(
-      QStringLiteral("<%1(/?>|(\\s+[^>]*>))").arg(tagRe));
-  const QRegularExpression endTag(QStringLiteral("</%1>").arg(tagRe));
 
   auto value = getSafeString(input);
   const auto safeInput = value.isSafe();
-  value.get().remove(startTag);
-  value.get().remove(endTag);
+
+  const auto plainTags = std::all_of(
+      tags.constBegin(), tags.constEnd(), [](const QString &tag) {
+        return std::all_of(tag.constBegin(), tag.constEnd(), [](QChar c) {
+          return isAsciiWordCharacter(c) || c == QLatin1Char('-');
+        });
+      });
+  if (plainTags) {
+    // The start tags are removed first, and the end tags from what remains.
+    const auto withoutStartTags = removeTags(value.get(), tags, false);
+    value = withContent(value, removeTags(withoutStartTags, tags, true),
+                        SafeString::IsNotSafe);
+  } else {
+    // The tags are patterns of a regular expression.
+    const auto tagRe
+        = QStringLiteral("(%1)").arg(tags.join(QChar::fromLatin1('|')));
+    const QRegularExpression startTag(
+        QStringLiteral("<%1(/?>|(\\s+[^>]*>))").arg(tagRe));
+    const QRegularExpression endTag(QStringLiteral("</%1>").arg(tagRe));
+    value.get().remove(startTag);
+    value.get().remove(endTag);
+  }
   if (safeInput)
     return markSafe(value);
   return value;
@@ -338,12 +648,27 @@ QVariant StripTagsFilter::doFilter(const QVariant &input,
 {
   Q_UNUSED(argument)
   Q_UNUSED(autoescape)
-  static QRegularExpression tagRe(QStringLiteral("<[^>]*>"),
-                                  QRegularExpression::InvertedGreedinessOption);
-
   QString value = getSafeString(input);
-  value.remove(tagRe);
-  return value;
+
+  // Removes everything from each '<' to the next '>', like the regular
+  // expression "<[^>]*>" would.
+  auto start = value.indexOf(QLatin1Char('<'));
+  if (start == -1)
+    return value;
+
+  QString output;
+  output.reserve(value.size());
+  auto copied = 0;
+  while (start != -1) {
+    const auto end = value.indexOf(QLatin1Char('>'), start + 1);
+    if (end == -1)
+      break;
+    output.append(value.constData() + copied, start - copied);
+    copied = end + 1;
+    start = value.indexOf(QLatin1Char('<'), copied);
+  }
+  output.append(value.constData() + copied, value.size() - copied);
+  return output;
 }
 
 QVariant WordWrapFilter::doFilter(const QVariant &input,
@@ -353,35 +678,54 @@ QVariant WordWrapFilter::doFilter(const QVariant &input,
   Q_UNUSED(autoescape)
   QString _input = getSafeString(input);
   auto width = argument.value<int>();
-  auto partList = _input.split(QLatin1Char(' '),
-#if QT_VERSION < QT_VERSION_CHECK(5, 14, 0)
-                               QString::SkipEmptyParts
-#else
-                               Qt::SkipEmptyParts
-#endif
-  );
-  if (partList.isEmpty())
-    return {};
-  auto output = partList.takeFirst();
-  auto pos = output.size() - output.lastIndexOf(QLatin1Char('\n')) - 1;
-  for (const QString &part : qAsConst(partList)) {
-    QStringList lines;
-    if (part.contains(QLatin1Char('\n'))) {
-      lines = part.split(QLatin1Char('\n'));
-    } else {
-      lines.append(part);
+
+  // The words are the parts separated by spaces, which may contain newlines.
+  const auto size = _input.size();
+  QString output;
+  auto first = true;
+  auto pos = 0;
+  auto nextNewline = -1;
+  for (auto start = 0;;) {
+    while (start < size && _input.at(start) == QLatin1Char(' '))
+      ++start;
+    if (start == size)
+      break;
+    auto end = _input.indexOf(QLatin1Char(' '), start);
+    if (end == -1)
+      end = size;
+
+    // Only search again once the newline found last is passed.
+    if (nextNewline != size && nextNewline < start) {
+      nextNewline = _input.indexOf(QLatin1Char('\n'), start);
+      if (nextNewline == -1)
+        nextNewline = size;
     }
-    pos += lines.first().size() + 1;
-    if (pos > width) {
-      output.append(QLatin1Char('\n'));
-      pos += lines.last().size();
+    const auto firstNewline = nextNewline;
+    const auto hasNewline = firstNewline < end;
+    const auto lastLineSize
+        = hasNewline ? end - _input.lastIndexOf(QLatin1Char('\n'), end - 1) - 1
+                     : end - start;
+
+    if (first) {
+      output.reserve(size);
+      pos = lastLineSize;
+      first = false;
     } else {
-      output.append(QLatin1Char(' '));
-      if (lines.size() > 1)
-        pos += lines.last().size();
+      pos += (hasNewline ? firstNewline - start : end - start) + 1;
+      if (pos > width) {
+        output.append(QLatin1Char('\n'));
+        pos += lastLineSize;
+      } else {
+        output.append(QLatin1Char(' '));
+        if (hasNewline)
+          pos += lastLineSize;
+      }
     }
-    output.append(part);
+    output.append(_input.constData() + start, end - start);
+    start = end;
   }
+  if (first)
+    return {};
   return output;
 }
 
@@ -425,23 +769,63 @@ QVariant SafeSequenceFilter::doFilter(const QVariant &input,
   return list;
 }
 
+/**
+  Appends @p text to @p output, with each newline replaced by a line break.
+*/
+static void appendLineBreaks(QString *output, const QChar *text, int size)
+{
+  auto start = 0;
+  for (auto i = 0; i < size; ++i) {
+    if (text[i] == QLatin1Char('\n')) {
+      output->append(text + start, i - start);
+      output->append(QStringLiteral("<br />"));
+      start = i + 1;
+    }
+  }
+  output->append(text + start, size - start);
+}
+
 QVariant LineBreaksFilter::doFilter(const QVariant &input,
                                     const QVariant &argument,
                                     bool autoescape) const
 {
   Q_UNUSED(argument)
   auto inputString = getSafeString(input);
-  static const QRegularExpression re(QStringLiteral("\n{2,}"));
-  QStringList output;
-
-  for (const QString &bit : inputString.get().split(re)) {
-    auto _bit = SafeString(bit, inputString.isSafe());
-    if (autoescape)
-      _bit = conditionalEscape(_bit);
-    _bit.get().replace(QLatin1Char('\n'), QStringLiteral("<br />"));
-    output.append(QStringLiteral("<p>%1</p>").arg(_bit));
+  const QString &text = inputString.get();
+  const auto size = text.size();
+  const auto escapeBits = autoescape && !inputString.isSafe();
+
+  // Each paragraph, separated by two or more newlines, is wrapped in <p>.
+  QString output;
+  output.reserve(size + size / 8 + 8);
+  for (auto start = 0;;) {
+    auto end = text.indexOf(QStringLiteral("\n\n"), start);
+    auto next = end;
+    if (end == -1) {
+      end = size;
+    } else {
+      next = end + 2;
+      while (next < size && text.at(next) == QLatin1Char('\n'))
+        ++next;
+    }
+
+    if (start != 0)
+      output.append(QStringLiteral("\n\n"));
+    output.append(QStringLiteral("<p>"));
+    if (escapeBits) {
+      const QString bit
+          = conditionalEscape(SafeString(text.mid(start, end - start), false));
+      appendLineBreaks(&output, bit.constData(), bit.size());
+    } else {
+      appendLineBreaks(&output, text.constData() + start, end - start);
+    }
+    output.append(QStringLiteral("</p>"));
+
+    if (next == -1)
+      break;
+    start = next;
   }
-  return markSafe(output.join(QStringLiteral("\n\n")));
+  return markSafe(output);
 }
 
 QVariant LineBreaksBrFilter::doFilter(const QVariant &input,
@@ -457,19 +841,46 @@ QVariant LineBreaksBrFilter::doFilter(const QVariant &input,
       inputString.get().replace(QLatin1Char('\n'), QStringLiteral("<br />")));
 }
 
-static QString nofailStringToAscii(const QString &input)
+void LineBreaksBrFilter::filterInPlace(SafeString &input,
+                                       const QVariant &argument,
+                                       bool autoescape) const
 {
-  QString output;
-  output.reserve(input.size());
+  Q_UNUSED(argument)
+  // The input is always a string when filtering in place.
+  if (autoescape)
+    input = conditionalEscape(input);
+  input.get().replace(QLatin1Char('\n'), QStringLiteral("<br />"));
+  input.setSafety(SafeString::IsSafe);
+}
 
-  auto it = input.constBegin();
-  const auto end = input.constEnd();
-  static const QChar asciiEndPoint(128);
-  for (; it != end; ++it)
-    if (*it < asciiEndPoint)
-      output.append(*it);
+void LineBreaksBrFilter::doFilterToStream(const QVariant &input,
+                                          const QVariant &argument,
+                                          OutputStream &stream,
+                                          bool autoescape) const
+{
+  auto inputString = getSafeString(input);
+  if (autoescape && isSafeString(input))
+    inputString = conditionalEscape(inputString);
 
-  return output;
+  // The whole result, line breaks included, is escaped only if it still needs
+  // escaping after being marked safe.
+  if (escapesResult(this, input, true, inputString.needsEscape(),
+                    autoescape)) {
+    writeResult(this, input, argument, stream, autoescape);
+    return;
+  }
+
+  // Writes the lines between the line breaks without copying them.
+  const QString &text = inputString.get();
+  auto start = 0;
+  for (auto end = text.indexOf(QLatin1Char('\n')); end != -1;
+       end = text.indexOf(QLatin1Char('\n'), start)) {
+    stream << QString::fromRawData(text.constData() + start, end - start)
+           << QStringLiteral("<br />");
+    start = end + 1;
+  }
+  stream << QString::fromRawData(text.constData() + start,
+                                 text.size() - start);
 }
 
 QVariant SlugifyFilter::doFilter(const QVariant &input,
@@ -479,14 +890,36 @@ QVariant SlugifyFilter::doFilter(const QVariant &input,
   Q_UNUSED(argument)
   Q_UNUSED(autoescape)
   QString inputString = getSafeString(input);
-  inputString = inputString.normalized(QString::NormalizationForm_KD);
-  inputString = nofailStringToAscii(inputString);
-  inputString
-      = inputString.remove(QRegularExpression(QStringLiteral("[^\\w\\s-]")))
-            .trimmed()
-            .toLower();
-  return markSafe(inputString.replace(
-      QRegularExpression(QStringLiteral("[-\\s]+")), QChar::fromLatin1('-')));
+  // ASCII text is not changed by the normalization.
+  if (std::any_of(inputString.constBegin(), inputString.constEnd(),
+                  [](QChar c) { return c.unicode() >= 128; }))
+    inputString = inputString.normalized(QString::NormalizationForm_KD);
+
+  // Keeps the ASCII word characters in lower case, and replaces each run of
+  // spaces and hyphens by one hyphen. Runs at either end are dropped unless
+  // they contain a hyphen, as the spaces around them would be trimmed.
+  QString output;
+  output.reserve(inputString.size());
+  auto inRun = false;
+  auto runHasHyphen = false;
+  for (const auto c : qAsConst(inputString)) {
+    const auto u = c.unicode();
+    if (u >= 128)
+      continue;
+    if (isAsciiWordCharacter(c)) {
+      if (inRun && (runHasHyphen || !output.isEmpty()))
+        output.append(QLatin1Char('-'));
+      inRun = false;
+      runHasHyphen = false;
+      output.append(u >= 'A' && u <= 'Z' ? QChar(u + ('a' - 'A')) : c);
+    } else if (u == '-' || isAsciiSpace(c)) {
+      inRun = true;
+      runHasHyphen |= u == '-';
+    }
+  }
+  if (inRun && runHasHyphen)
+    output.append(QLatin1Char('-'));
+  return markSafe(output);
 }
 
 QVariant FileSizeFormatFilter::doFilter(const QVariant &input,
@@ -598,3 +1031,18 @@ QVariant TruncateCharsFilter::doFilter(const QVariant &input,
   retString.append(QStringLiteral("..."));
   return retString;
 }
+
+void TruncateCharsFilter::filterInPlace(SafeString &input,
+                                        const QVariant &argument,
+                                        bool autoescape) const
+{
+  Q_UNUSED(autoescape)
+  const auto count = getSafeString(argument).get().toInt();
+
+  QString &content = input.get();
+  if (content.length() >= count) {
+    content.truncate(count);
+    content.append(QStringLiteral("..."));
+  }
+  markAsString(input);
+}
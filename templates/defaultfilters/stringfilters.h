@@ -27,22 +27,28 @@
 
 using namespace Grantlee;
 
-class AddSlashesFilter : public Filter
+class AddSlashesFilter : public Filter, public InPlaceFilter
 {
 public:
   bool isSafe() const override { return true; }
 
   QVariant doFilter(const QVariant &input, const QVariant &argument = {},
                     bool autoescape = {}) const override;
+
+  void filterInPlace(SafeString &input, const QVariant &argument,
+                     bool autoescape) const override;
 };
 
-class CapFirstFilter : public Filter
+class CapFirstFilter : public Filter, public InPlaceFilter
 {
 public:
   bool isSafe() const override { return true; }
 
   QVariant doFilter(const QVariant &input, const QVariant &argument = {},
                     bool autoescape = {}) const override;
+
+  void filterInPlace(SafeString &input, const QVariant &argument,
+                     bool autoescape) const override;
 };
 
 class EscapeJsFilter : public Filter
@@ -66,20 +72,29 @@ public:
                     bool autoescape = {}) const override;
 };
 
-class CutFilter : public Filter
+class CutFilter : public Filter, public InPlaceFilter
 {
 public:
   QVariant doFilter(const QVariant &input, const QVariant &argument = {},
                     bool autoescape = {}) const override;
+
+  void filterInPlace(SafeString &input, const QVariant &argument,
+                     bool autoescape) const override;
 };
 
-class SafeFilter : public Filter
+class SafeFilter : public Filter, public InPlaceFilter, public StreamingFilter
 {
 public:
   bool isSafe() const override { return true; }
 
   QVariant doFilter(const QVariant &input, const QVariant &argument = {},
                     bool autoescape = {}) const override;
+
+  void filterInPlace(SafeString &input, const QVariant &argument,
+                     bool autoescape) const override;
+
+  void doFilterToStream(const QVariant &input, const QVariant &argument,
+                        OutputStream &stream, bool autoescape) const override;
 };
 
 class LineNumbersFilter : public Filter
@@ -91,13 +106,16 @@ public:
                     bool autoescape = {}) const override;
 };
 
-class LowerFilter : public Filter
+class LowerFilter : public Filter, public InPlaceFilter
 {
 public:
   bool isSafe() const override { return true; }
 
   QVariant doFilter(const QVariant &input, const QVariant &argument = {},
                     bool autoescape = {}) const override;
+
+  void filterInPlace(SafeString &input, const QVariant &argument,
+                     bool autoescape) const override;
 };
 
 class StringFormatFilter : public Filter
@@ -109,13 +127,16 @@ public:
                     bool autoescape = {}) const override;
 };
 
-class TitleFilter : public Filter
+class TitleFilter : public Filter, public InPlaceFilter
 {
 public:
   bool isSafe() const override { return true; }
 
   QVariant doFilter(const QVariant &input, const QVariant &argument = {},
                     bool autoescape = {}) const override;
+
+  void filterInPlace(SafeString &input, const QVariant &argument,
+                     bool autoescape) const override;
 };
 
 class TruncateWordsFilter : public Filter
@@ -127,7 +148,7 @@ public:
                     bool autoescape = {}) const override;
 };
 
-class UpperFilter : public Filter
+class UpperFilter : public Filter, public InPlaceFilter
 {
 public:
   // &amp; may be safe, but it will be changed to &AMP; which is not safe.
@@ -135,6 +156,9 @@ public:
 
   QVariant doFilter(const QVariant &input, const QVariant &argument = {},
                     bool autoescape = {}) const override;
+
+  void filterInPlace(SafeString &input, const QVariant &argument,
+                     bool autoescape) const override;
 };
 
 class WordCountFilter : public Filter
@@ -173,22 +197,35 @@ public:
                     bool autoescape = {}) const override;
 };
 
-class EscapeFilter : public Filter
+class EscapeFilter : public Filter, public InPlaceFilter, public StreamingFilter
 {
 public:
   bool isSafe() const override { return true; }
 
   QVariant doFilter(const QVariant &input, const QVariant &argument = {},
                     bool autoescape = {}) const override;
+
+  void filterInPlace(SafeString &input, const QVariant &argument,
+                     bool autoescape) const override;
+
+  void doFilterToStream(const QVariant &input, const QVariant &argument,
+                        OutputStream &stream, bool autoescape) const override;
 };
 
-class ForceEscapeFilter : public Filter
+class ForceEscapeFilter : public Filter, public InPlaceFilter,
+                          public StreamingFilter
 {
 public:
   bool isSafe() const override { return true; }
 
   QVariant doFilter(const QVariant &input, const QVariant &argument = {},
                     bool autoescape = {}) const override;
+
+  void filterInPlace(SafeString &input, const QVariant &argument,
+                     bool autoescape) const override;
+
+  void doFilterToStream(const QVariant &input, const QVariant &argument,
+                        OutputStream &stream, bool autoescape) const override;
 };
 
 class RemoveTagsFilter : public Filter
@@ -241,13 +278,20 @@ public:
   bool isSafe() const override { return true; }
 };
 
-class LineBreaksBrFilter : public Filter
+class LineBreaksBrFilter : public Filter, public InPlaceFilter,
+                           public StreamingFilter
 {
 public:
   QVariant doFilter(const QVariant &input, const QVariant &argument = {},
                     bool autoescape = {}) const override;
 
   bool isSafe() const override { return true; }
+
+  void filterInPlace(SafeString &input, const QVariant &argument,
+                     bool autoescape) const override;
+
+  void doFilterToStream(const QVariant &input, const QVariant &argument,
+                        OutputStream &stream, bool autoescape) const override;
 };
 
 class SlugifyFilter : public Filter
@@ -269,7 +313,7 @@ public:
   bool isSafe() const override { return true; }
 };
 
-class TruncateCharsFilter : public Filter
+class TruncateCharsFilter : public Filter, public InPlaceFilter
 {
 public:
   QVariant doFilter(const QVariant &input,
@@ -277,6 +321,9 @@ public:
                     bool autoescape = {}) const override;
 
   bool isSafe() const override { return true; }
+
+  void filterInPlace(SafeString &input, const QVariant &argument,
+                     bool autoescape) const override;
 };
 
 #endif
@@ -0,0 +1,78 @@
+/*
+  This file is part of the Grantlee template system.
+
+  Copyright (c) 2026 agent <agent@local>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either version
+  2.1 of the Licence, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef ATTRIBUTEPATH_P_H
+#define ATTRIBUTEPATH_P_H
+
+#include <QtCore/QStringList>
+
+#include "context.h"
+#include "metatype.h"
+
+using namespace Grantlee;
+
+/**
+  A path of attributes like "author.name", split once so that it can be
+  looked up on many objects. Looking it up on an object gives the same result
+  as resolving "var.author.name" with the object inserted as "var".
+
+  Paths which a Variable would reject, such as those with attributes
+  beginning with an underscore, are not valid, and have to be resolved
+  through a FilterExpression instead.
+*/
+class AttributePath
+{
+public:
+  AttributePath() = default;
+
+  explicit AttributePath(const QString &path)
+  {
+    const auto attributes = path.split(QLatin1Char('.'));
+    for (const auto &attribute : attributes) {
+      if (attribute.isEmpty() || attribute.startsWith(QLatin1Char('_')))
+        return;
+      for (const auto &c : attribute) {
+        const auto u = c.unicode();
+        if (!((u >= 'a' && u <= 'z') || (u >= 'A' && u <= 'Z')
+              || (u >= '0' && u <= '9') || u == '_'))
+          return;
+      }
+    }
+    m_attributes = attributes;
+  }
+
+  bool isValid() const { return !m_attributes.isEmpty(); }
+
+  QVariant lookUp(const QVariant &object, Context *c) const
+  {
+    auto value = c->resolveLazyValue(object);
+    for (const auto &attribute : m_attributes) {
+      value = c->resolveLazyValue(MetaType::lookup(value, attribute));
+      if (!value.isValid())
+        return {};
+    }
+    return value;
+  }
+
+private:
+  QStringList m_attributes;
+};
+
+#endif
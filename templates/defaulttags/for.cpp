@@ -23,8 +23,10 @@
 #include "../lib/exception.h"
 #include "metaenumvariable_p.h"
 #include "parser.h"
+#include "rendercontext.h"
+#include "sequenceview_p.h"
 
-#include <QtCore/QSequentialIterable>
+#include <algorithm>
 
 ForNodeFactory::ForNodeFactory() = default;
 
@@ -100,6 +102,12 @@ ForNode::ForNode(const Grantlee::Token &token,
     : Node(token, parent), m_loopVars(loopVars), m_filterExpression(fe),
       m_isReversed(reversed)
 {
+  // Unpacking an object looks up each loop variable as an attribute of it.
+  if (m_loopVars.size() > 1) {
+    m_loopVarPaths.reserve(m_loopVars.size());
+    for (const auto &loopVar : m_loopVars)
+      m_loopVarPaths.append(AttributePath(loopVar));
+  }
 }
 
 void ForNode::setLoopList(const NodeList &loopNodeList)
@@ -112,22 +120,115 @@ void ForNode::setEmptyList(const NodeList &emptyList)
   m_emptyNodeList = emptyList;
 }
 
+bool ForNode::isInLoop(const Node *node) const
+{
+  return std::find(m_loopNodeList.constBegin(), m_loopNodeList.constEnd(),
+                   node)
+         != m_loopNodeList.constEnd();
+}
+
+int ForNode::loopRun(Context *c) const
+{
+  return c->renderContext()->data(this).toInt();
+}
+
+// Returns the rows of @p rows as a forward iterable, which fetches more rows
+// only when the next one is needed.
+static ForwardIterable modelIterable(const ModelRows &rows)
+{
+  ForwardIterable iterable;
+  iterable.begin = QSharedPointer<const ForwardIterable::BeginFunction>(
+      new ForwardIterable::BeginFunction([rows] {
+        auto row = 0;
+        return ForwardIterable::NextFunction(
+            [rows, row](QVariant &item) mutable {
+              if (!rows.hasRow(row))
+                return false;
+              item = rows.at(row++);
+              return true;
+            });
+      }));
+  return iterable;
+}
+
 static const char forloop[] = "forloop";
 static const char parentloop[] = "parentloop";
 
-void ForNode::insertLoopVariables(Context *c, int listSize, int i)
+void ForNode::insertLoopVariables(Context *c, int i, bool last, int listSize,
+                                  const std::function<int()> &lazySize)
 {
   auto forloopHash = c->lookup(QStringLiteral("forloop")).value<QVariantHash>();
   // some magic variables injected into the context while rendering.
   forloopHash.insert(QStringLiteral("counter0"), i);
   forloopHash.insert(QStringLiteral("counter"), i + 1);
-  forloopHash.insert(QStringLiteral("revcounter"), listSize - i);
-  forloopHash.insert(QStringLiteral("revcounter0"), listSize - i - 1);
+  // The size of a forward iterable may not be known.
+  if (listSize >= 0) {
+    forloopHash.insert(QStringLiteral("revcounter"), listSize - i);
+    forloopHash.insert(QStringLiteral("revcounter0"), listSize - i - 1);
+  } else if (lazySize) {
+    // Counting the items may fetch all of them, so it is only done if the
+    // template uses the reverse counters.
+    forloopHash.insert(
+        QStringLiteral("revcounter"),
+        Context::lazyValue([lazySize, i] { return lazySize() - i; }));
+    forloopHash.insert(
+        QStringLiteral("revcounter0"),
+        Context::lazyValue([lazySize, i] { return lazySize() - i - 1; }));
+  } else {
+    forloopHash.remove(QStringLiteral("revcounter"));
+    forloopHash.remove(QStringLiteral("revcounter0"));
+  }
   forloopHash.insert(QStringLiteral("first"), (i == 0));
-  forloopHash.insert(QStringLiteral("last"), (i == listSize - 1));
+  forloopHash.insert(QStringLiteral("last"), last);
   c->insert(QLatin1String(forloop), forloopHash);
 }
 
+void ForNode::renderItem(OutputStream *stream, Context *c,
+                         const QVariant &v) const
+{
+  if (m_loopVars.size() > 1) {
+    if (v.userType() == qMetaTypeId<QVariantList>()) {
+      auto vList = v.value<QVariantList>();
+      auto varsSize = qMin(m_loopVars.size(), vList.size());
+      auto j = 0;
+      for (; j < varsSize; ++j) {
+        c->insert(m_loopVars.at(j), vList.at(j));
+      }
+      // If any of the named vars don't have an item in the context,
+      // insert an invalid object for them.
+      for (; j < m_loopVars.size(); ++j) {
+        c->insert(m_loopVars.at(j), QVariant());
+      }
+
+    } else {
+      // We don't have a hash, but we have to unpack several values
+      // from each
+      // item
+      // in the list. And each item in the list is not itself a list.
+      // Probably have a list of objects that we're taking properties
+      // from.
+      for (auto j = 0; j < m_loopVars.size(); ++j) {
+        const auto &loopVar = m_loopVars.at(j);
+        const auto &path = m_loopVarPaths.at(j);
+        if (path.isValid()) {
+          c->insert(loopVar, path.lookUp(v, c));
+          continue;
+        }
+        c->push();
+        c->insert(QStringLiteral("var"), v);
+        auto resolvedFE
+            = FilterExpression(QStringLiteral("var.") + loopVar, nullptr)
+                  .resolve(c);
+        c->pop();
+        c->insert(loopVar, resolvedFE);
+      }
+    }
+  } else {
+    c->insert(m_loopVars[0], v);
+  }
+  renderLoop(stream, c);
+}
+
 void ForNode::renderLoop(OutputStream *stream, Context *c) const
 {
   for (auto j = 0; j < m_loopNodeList.size(); j++) {
@@ -135,6 +236,31 @@ void ForNode::renderLoop(OutputStream *stream, Context *c) const
   }
 }
 
+bool ForNode::renderForwardIterable(
+    OutputStream *stream, Context *c, const ForwardIterable &iterable,
+    const std::function<int()> &lazySize) const
+{
+  const auto next = (*iterable.begin)();
+  QVariant item;
+  if (!next(item))
+    return false;
+
+  auto &run = c->renderContext()->data(this);
+  run = run.toInt() + 1;
+
+  // Each item is rendered once the next one has been produced, so that
+  // forloop.last is known while holding no more than two items.
+  QVariant nextItem;
+  auto hasNext = true;
+  for (auto i = 0; hasNext; ++i) {
+    hasNext = next(nextItem);
+    insertLoopVariables(c, i, !hasNext, iterable.size, lazySize);
+    renderItem(stream, c, item);
+    item.swap(nextItem);
+  }
+  return true;
+}
+
 void ForNode::render(OutputStream *stream, Context *c) const
 {
   QVariantHash forloopHash;
@@ -148,8 +274,6 @@ void ForNode::render(OutputStream *stream, Context *c) const
     c->insert(QLatin1String(forloop), forloopHash);
   }
 
-  auto unpack = m_loopVars.size() > 1;
-
   c->push();
 
   auto varFE = m_filterExpression.resolve(c);
@@ -169,12 +293,37 @@ void ForNode::render(OutputStream *stream, Context *c) const
     varFE = list;
   }
 
-  if (!varFE.canConvert<QVariantList>()) {
+  // A forward iterable is rendered as its items are produced. Reversing it
+  // requires all of its items, so the view collects them into a list then.
+  if (SequenceView::isForwardIterable(varFE) && m_isReversed != IsReversed) {
+    const auto rendered
+        = renderForwardIterable(stream, c, varFE.value<ForwardIterable>());
+    c->pop();
+    if (!rendered)
+      m_emptyNodeList.render(stream, c);
+    return;
+  }
+
+  // The rows of a model are fetched as the loop reaches them, unless the
+  // template uses the reverse counters.
+  const auto rows = ModelRows::fromVariant(varFE);
+  if (rows.isValid() && m_isReversed != IsReversed) {
+    const auto rendered = renderForwardIterable(
+        stream, c, modelIterable(rows), [rows] { return rows.size(); });
+    c->pop();
+    if (!rendered)
+      m_emptyNodeList.render(stream, c);
+    return;
+  }
+
+  // The items are read from the container in place, so that a large
+  // container is not copied into a QVariantList before rendering.
+  const SequenceView iter(varFE);
+  if (!iter.isValid()) {
     c->pop();
     return m_emptyNodeList.render(stream, c);
   }
 
-  auto iter = varFE.value<QSequentialIterable>();
   const auto listSize = iter.size();
 
   // If it's an iterable type, iterate, otherwise it's a list of one.
@@ -183,48 +332,15 @@ void ForNode::render(OutputStream *stream, Context *c) const
     return m_emptyNodeList.render(stream, c);
   }
 
+  auto &run = c->renderContext()->data(this);
+  run = run.toInt() + 1;
+
   auto i = 0;
   for (auto it = m_isReversed == IsReversed ? iter.end() - 1 : iter.begin();
        m_isReversed == IsReversed ? it != iter.begin() - 1 : it != iter.end();
        m_isReversed == IsReversed ? --it : ++it) {
-    const auto v = *it;
-    insertLoopVariables(c, listSize, i);
-
-    if (unpack) {
-      if (v.userType() == qMetaTypeId<QVariantList>()) {
-        auto vList = v.value<QVariantList>();
-        auto varsSize = qMin(m_loopVars.size(), vList.size());
-        auto j = 0;
-        for (; j < varsSize; ++j) {
-          c->insert(m_loopVars.at(j), vList.at(j));
-        }
-        // If any of the named vars don't have an item in the context,
-        // insert an invalid object for them.
-        for (; j < m_loopVars.size(); ++j) {
-          c->insert(m_loopVars.at(j), QVariant());
-        }
-
-      } else {
-        // We don't have a hash, but we have to unpack several values
-        // from each
-        // item
-        // in the list. And each item in the list is not itself a list.
-        // Probably have a list of objects that we're taking properties
-        // from.
-        for (const QString &loopVar : m_loopVars) {
-          c->push();
-          c->insert(QStringLiteral("var"), v);
-          auto resolvedFE
-              = FilterExpression(QStringLiteral("var.") + loopVar, nullptr)
-                    .resolve(c);
-          c->pop();
-          c->insert(loopVar, resolvedFE);
-        }
-      }
-    } else {
-      c->insert(m_loopVars[0], v);
-    }
-    renderLoop(stream, c);
+    insertLoopVariables(c, i, i == listSize - 1, listSize);
+    renderItem(stream, c, *it);
     ++i;
   }
   c->pop();
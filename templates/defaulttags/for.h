@@ -21,8 +21,16 @@
 #ifndef FORNODE_H
 #define FORNODE_H
 
+#include "attributepath_p.h"
 #include "node.h"
 
+#include <functional>
+
+namespace Grantlee
+{
+struct ForwardIterable;
+}
+
 using namespace Grantlee;
 
 class ForNodeFactory : public AbstractNodeFactory
@@ -48,11 +56,25 @@ public:
 
   void render(OutputStream *stream, Context *c) const override;
 
+  // Returns whether @p node is rendered for each item, rather than when the
+  // loop is empty.
+  bool isInLoop(const Node *node) const;
+
+  // Returns how many times the loop has started in the current render, so
+  // that tags in it can reset their state for each run of the loop.
+  int loopRun(Context *c) const;
+
 private:
-  static void insertLoopVariables(Context *c, int listSize, int i);
+  static void insertLoopVariables(Context *c, int i, bool last, int listSize,
+                                  const std::function<int()> &lazySize = {});
+  void renderItem(OutputStream *stream, Context *c, const QVariant &v) const;
   void renderLoop(OutputStream *stream, Context *c) const;
+  bool renderForwardIterable(OutputStream *stream, Context *c,
+                             const ForwardIterable &iterable,
+                             const std::function<int()> &lazySize = {}) const;
 
   QStringList m_loopVars;
+  QVector<AttributePath> m_loopVarPaths;
   FilterExpression m_filterExpression;
   NodeList m_loopNodeList;
   NodeList m_emptyNodeList;
@@ -28,6 +28,7 @@
 #include "../lib/exception.h"
 #include "filterexpression.h"
 #include "node.h"
+#include "sequenceview_p.h"
 #include "util.h"
 
 #if (QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)) && \
@@ -81,10 +82,12 @@ static bool contains(const QVariant &needle, const QVariant &var)
   if (Grantlee::isSafeString(var)) {
     return Grantlee::getSafeString(var).get().contains(
         Grantlee::getSafeString(needle));
-  } else if (var.canConvert<QVariantList>()) {
-    auto container = var.value<QVariantList>();
+  } else if (var.canConvert<QVariantList>()
+             || Grantlee::SequenceView::isForwardIterable(var)) {
+    const Grantlee::SequenceView container(var);
     if (Grantlee::isSafeString(needle)) {
-      return container.contains(Grantlee::getSafeString(needle).get());
+      return container.contains(
+          QString(Grantlee::getSafeString(needle).get()));
     }
     return container.contains(needle);
   }
@@ -20,9 +20,15 @@
 
 #include "ifchanged.h"
 
+#include "for.h"
 #include "parser.h"
+#include "rendercontext.h"
 
 #include <QtCore/QDateTime>
+#include <QtCore/QTextStream>
+#include <QtCore/qnumeric.h>
+
+#include <cstring>
 
 IfChangedNodeFactory::IfChangedNodeFactory() = default;
 
@@ -58,7 +64,6 @@ IfChangedNode::IfChangedNode(const Grantlee::Token &token,
                              QObject *parent)
     : Node(token, parent), m_filterExpressions(feList)
 {
-  m_lastSeen = QVariant();
   m_id = QString::number(reinterpret_cast<qint64>(this));
 }
 
@@ -72,60 +77,202 @@ void IfChangedNode::setFalseList(const NodeList &falseList)
   m_falseList = falseList;
 }
 
+namespace
+{
+
+/**
+  The state of an ifchanged tag in one render. The watched content or values
+  are kept as a hash, unless some value can not be hashed.
+*/
+struct IfChangedState {
+  int loopRun = 0;
+  bool seen = false;
+  bool hashed = false;
+  quint64 hash = 0;
+  QVariantList values;
+};
+
+// The 64-bit FNV-1a hash.
+const quint64 s_hashSeed = Q_UINT64_C(14695981039346656037);
+
+void hashUnit(quint64 *hash, quint64 unit)
+{
+  *hash ^= unit;
+  *hash *= Q_UINT64_C(1099511628211);
+}
+
+void hashString(quint64 *hash, const QString &string)
+{
+  hashUnit(hash, quint64(string.size()));
+  for (const auto &c : string)
+    hashUnit(hash, c.unicode());
+}
+
+void hashInteger(quint64 *hash, qint64 value)
+{
+  for (auto i = 0; i < 64; i += 16)
+    hashUnit(hash, quint64(value >> i) & 0xffff);
+}
+
+/**
+  Adds @p value to @p hash, so that values which compare equal hash equally.
+  Returns false if the type of @p value is not supported.
+*/
+bool hashVariant(quint64 *hash, const QVariant &value)
+{
+  switch (value.userType()) {
+  case QMetaType::Bool:
+  case QMetaType::Int:
+  case QMetaType::UInt:
+  case QMetaType::LongLong:
+  case QMetaType::ULongLong:
+    hashInteger(hash, value.toLongLong());
+    return true;
+  case QMetaType::Double: {
+    // NaN is not equal to itself, so it is compared as a value, which makes
+    // it count as changed every time.
+    const auto d = value.toDouble();
+    if (qIsNaN(d))
+      return false;
+    // Integral doubles compare equal to integers.
+    if (d >= -9e18 && d <= 9e18 && d == double(qint64(d))) {
+      hashInteger(hash, qint64(d));
+    } else {
+      qint64 bits;
+      std::memcpy(&bits, &d, sizeof(bits));
+      hashInteger(hash, bits);
+    }
+    return true;
+  }
+  case QMetaType::QString:
+    hashString(hash, value.toString());
+    return true;
+  case QMetaType::QObjectStar:
+    hashInteger(hash, reinterpret_cast<qint64>(value.value<QObject *>()));
+    return true;
+  default:
+    if (value.userType() == qMetaTypeId<Grantlee::SafeString>()) {
+      hashString(hash, value.value<Grantlee::SafeString>().get());
+      return true;
+    }
+    return false;
+  }
+}
+}
+
+Q_DECLARE_METATYPE(IfChangedState)
+
+// The state is per render, so that the template can be rendered on several
+// threads at once. It is looked up again after rendering other nodes, which
+// may add their own data.
+static IfChangedState *renderState(Context *c, const Node *node)
+{
+  auto &data = c->renderContext()->data(node);
+  if (data.userType() != qMetaTypeId<IfChangedState>())
+    data = QVariant::fromValue(IfChangedState());
+  return static_cast<IfChangedState *>(data.data());
+}
+
+const ForNode *IfChangedNode::enclosingLoop() const
+{
+  // The nodes of a template do not change once it is compiled.
+  std::call_once(m_enclosingLoopFound, [this] {
+    const QObject *child = this;
+    for (auto p = parent(); p; child = p, p = p->parent()) {
+      if (const auto forNode = qobject_cast<const ForNode *>(p)) {
+        if (forNode->isInLoop(static_cast<const Node *>(child)))
+          m_enclosingLoop = forNode;
+        return;
+      }
+    }
+  });
+  return m_enclosingLoop;
+}
+
 void IfChangedNode::render(OutputStream *stream, Context *c) const
 {
-  if (c->lookup(QStringLiteral("forloop")).isValid()
-      && (!c->lookup(QStringLiteral("forloop"))
-               .value<QVariantHash>()
-               .contains(m_id))) {
-    m_lastSeen = QVariant();
+  auto state = renderState(c, this);
+
+  // The state is reset each time the loop around the tag starts again.
+  if (const auto loop = enclosingLoop()) {
+    const auto loopRun = loop->loopRun(c);
+    if (state->loopRun != loopRun) {
+      *state = IfChangedState();
+      state->loopRun = loopRun;
+    }
+  } else if (c->lookup(QStringLiteral("forloop")).isValid()) {
+    // The loop is outside of this template, as with an included template.
     auto hash = c->lookup(QStringLiteral("forloop")).value<QVariantHash>();
-    hash.insert(m_id, 1);
-    c->insert(QStringLiteral("forloop"), hash);
+    if (!hash.contains(m_id)) {
+      *state = IfChangedState();
+      hash.insert(m_id, 1);
+      c->insert(QStringLiteral("forloop"), hash);
+    }
   }
 
-  QString watchedString;
-  QTextStream watchedTextStream(&watchedString);
-  auto watchedStream = stream->clone(&watchedTextStream);
+  const auto firstLoop = !state->seen;
+
   if (m_filterExpressions.isEmpty()) {
-    m_trueList.render(watchedStream.data(), c);
+    // The content is rendered once, and written from the buffer when it
+    // changed.
+    QString watchedString;
+    QTextStream watchedTextStream(&watchedString);
+    auto watchedStream = stream->clone(&watchedTextStream);
+    renderChanged(watchedStream.data(), c, firstLoop);
+    watchedTextStream.flush();
+    state = renderState(c, this);
+
+    auto hash = s_hashSeed;
+    hashString(&hash, watchedString);
+    if (!watchedString.isEmpty() && (firstLoop || hash != state->hash)) {
+      state->seen = true;
+      state->hash = hash;
+      (*stream) << watchedString;
+    } else if (!m_falseList.isEmpty()) {
+      m_falseList.render(stream, c);
+    }
+    return;
   }
+
+  auto hash = s_hashSeed;
+  auto hashed = true;
   QVariantList watchedVars;
+  watchedVars.reserve(m_filterExpressions.size());
   for (auto &i : m_filterExpressions) {
     auto var = i.resolve(c);
     if (!var.isValid()) {
       // silent error
       return;
     }
+    hashed = hashed && hashVariant(&hash, var);
     watchedVars.append(var);
   }
 
-  // In Qt6, QVariant::value<QVariantList>() converts a QString
-  // to a QList(QVariant(QChar, c)...).
-  // Avoid that conversion
-  QVariantList lastSeenVarList;
-  if (m_lastSeen.userType() != qMetaTypeId<QString>())
-    lastSeenVarList = m_lastSeen.value<QVariantList>();
-
-  // At first glance it looks like m_last_seen will always be invalid,
-  // But it will change because render is called multiple times by the parent
-  // {% for %} loop in the template.
-  if ((watchedVars != lastSeenVarList)
-      || (!watchedString.isEmpty()
-          && (watchedString != m_lastSeen.value<QString>()))) {
-    auto firstLoop = !m_lastSeen.isValid();
-    if (!watchedString.isEmpty())
-      m_lastSeen = watchedString;
+  const auto changed
+      = firstLoop || hashed != state->hashed
+        || (hashed ? hash != state->hash : watchedVars != state->values);
+  if (changed) {
+    state->seen = true;
+    state->hashed = hashed;
+    state->hash = hash;
+    if (hashed)
+      state->values.clear();
     else
-      m_lastSeen = watchedVars;
-    c->push();
-    QVariantHash hash;
-    // TODO: Document this.
-    hash.insert(QStringLiteral("firstloop"), firstLoop);
-    c->insert(QStringLiteral("ifchanged"), hash);
-    m_trueList.render(stream, c);
-    c->pop();
+      state->values = watchedVars;
+    renderChanged(stream, c, firstLoop);
   } else if (!m_falseList.isEmpty()) {
     m_falseList.render(stream, c);
   }
 }
+
+void IfChangedNode::renderChanged(OutputStream *stream, Context *c,
+                                  bool firstLoop) const
+{
+  c->push();
+  QVariantHash hash;
+  // TODO: Document this.
+  hash.insert(QStringLiteral("firstloop"), firstLoop);
+  c->insert(QStringLiteral("ifchanged"), hash);
+  m_trueList.render(stream, c);
+  c->pop();
+}
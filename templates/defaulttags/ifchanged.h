@@ -23,8 +23,12 @@
 
 #include "node.h"
 
+#include <mutex>
+
 using namespace Grantlee;
 
+class ForNode;
+
 class IfChangedNodeFactory : public AbstractNodeFactory
 {
   Q_OBJECT
@@ -48,11 +52,15 @@ public:
   void render(OutputStream *stream, Context *c) const override;
 
 private:
+  const ForNode *enclosingLoop() const;
+  void renderChanged(OutputStream *stream, Context *c, bool firstLoop) const;
+
   NodeList m_trueList;
   NodeList m_falseList;
   QList<FilterExpression> m_filterExpressions;
-  mutable QVariant m_lastSeen;
   QString m_id;
+  mutable std::once_flag m_enclosingLoopFound;
+  mutable const ForNode *m_enclosingLoop = nullptr;
 };
 
 #endif
@@ -22,8 +22,11 @@
 
 #include "../lib/exception.h"
 #include "parser.h"
+#include "sequenceview_p.h"
 #include "util.h"
 
+#include <utility>
+
 RegroupNodeFactory::RegroupNodeFactory() = default;
 
 Node *RegroupNodeFactory::getNode(const Grantlee::Token &tag, Parser *p) const
@@ -69,12 +72,32 @@ RegroupNode::RegroupNode(const Grantlee::Token &token,
     : Node(token, parent), m_target(target), m_expression(expression),
       m_varName(varName)
 {
+  // The key is a string literal, so it can be looked up the same way on each
+  // object.
+  const auto keyVariable = m_expression.variable();
+  if (m_expression.filters().isEmpty() && keyVariable.isConstant()
+      && !keyVariable.isLocalized())
+    m_keyPath = AttributePath(getSafeString(keyVariable.literal()));
+}
+
+QString RegroupNode::groupKey(const QVariant &object, const QString &keyName,
+                              Context *c) const
+{
+  if (m_keyPath.isValid())
+    return getSafeString(m_keyPath.lookUp(object, c));
+
+  c->push();
+  c->insert(QStringLiteral("var"), object);
+  const QString key = getSafeString(
+      FilterExpression(QStringLiteral("var.") + keyName, nullptr).resolve(c));
+  c->pop();
+  return key;
 }
 
 void RegroupNode::render(OutputStream *stream, Context *c) const
 {
   Q_UNUSED(stream)
-  auto objList = m_target.toList(c);
+  const SequenceView objList(m_target.resolve(c));
   if (objList.isEmpty()) {
     c->insert(m_varName, QVariantHash());
     return;
@@ -98,39 +121,29 @@ void RegroupNode::render(OutputStream *stream, Context *c) const
   // a
   // for loop.
 
+  // Each group is completed before it is added to the list, so that it is not
+  // copied out of the list again for each object.
   QVariantList contextList;
   const QString keyName = getSafeString(m_expression.resolve(c));
-  for (auto &var : objList) {
-    c->push();
-    c->insert(QStringLiteral("var"), var);
-    const QString key = getSafeString(
-        FilterExpression(QStringLiteral("var.") + keyName, nullptr).resolve(c));
-    c->pop();
-    QVariantHash hash;
-    if (!contextList.isEmpty()) {
-      auto hashVar = contextList.last();
-      hash = hashVar.value<QVariantHash>();
-    }
-
-    const auto it = hash.constFind(QStringLiteral("grouper"));
-    if (it == hash.constEnd() || it.value() != key) {
-      contextList.append(QVariantHash{
-          {QStringLiteral("grouper"), key},
-          {QStringLiteral("list"), QVariantList{var}},
-      });
+  QString currentKey;
+  QVariantList currentGroup;
+  for (const QVariant &var : objList) {
+    auto key = groupKey(var, keyName, c);
+    if (currentGroup.isEmpty() || key != currentKey) {
+      if (!currentGroup.isEmpty())
+        contextList.append(QVariantHash{
+            {QStringLiteral("grouper"), currentKey},
+            {QStringLiteral("list"), currentGroup},
+        });
+      currentKey = std::move(key);
+      currentGroup = QVariantList{var};
     } else {
-      QVariantList list;
-      auto itList = hash.find(QStringLiteral("list"));
-      if (itList != hash.end()) {
-        list = itList.value().value<QVariantList>();
-        list.append(var);
-        *itList = list;
-      } else {
-        list.append(var);
-        hash.insert(QStringLiteral("list"), list);
-      }
-      contextList[contextList.size() - 1] = hash;
+      currentGroup.append(var);
     }
   }
+  contextList.append(QVariantHash{
+      {QStringLiteral("grouper"), currentKey},
+      {QStringLiteral("list"), currentGroup},
+  });
   c->insert(m_varName, contextList);
 }
@@ -21,6 +21,7 @@
 #ifndef REGROUPNODE_H
 #define REGROUPNODE_H
 
+#include "attributepath_p.h"
 #include "node.h"
 
 using namespace Grantlee;
@@ -46,9 +47,13 @@ public:
   void render(OutputStream *stream, Context *c) const override;
 
 private:
+  QString groupKey(const QVariant &object, const QString &keyName,
+                   Context *c) const;
+
   FilterExpression m_target;
   FilterExpression m_expression;
   QString m_varName;
+  AttributePath m_keyPath;
 };
 
 #endif
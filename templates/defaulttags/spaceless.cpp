@@ -20,10 +20,136 @@
 
 #include "spaceless.h"
 
-#include <QtCore/QRegularExpression>
+#include <QtCore/QIODevice>
+#include <QtCore/QTextStream>
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+#include <QtCore/QTextCodec>
+#else
+#include <QtCore/QStringDecoder>
+#endif
 
 #include "parser.h"
-#include "util.h"
+
+namespace
+{
+
+// The whitespace matched by \s in the ">\s+<" pattern spaceless used to
+// replace, which did not use Unicode properties.
+bool isAsciiSpace(QChar c)
+{
+  const auto u = c.unicode();
+  return u == ' ' || (u >= '\t' && u <= '\r');
+}
+
+bool isAsciiSpace(const QChar *data, int size)
+{
+  for (auto i = 0; i < size; ++i) {
+    if (!isAsciiSpace(data[i]))
+      return false;
+  }
+  return true;
+}
+
+/**
+  Writes the text written to it to an OutputStream, with the whitespace
+  between tags and at either end removed. As with QString::trimmed, any
+  Unicode whitespace is removed at either end, but only ASCII whitespace is
+  removed between tags. Only a run of whitespace which may
+  still turn out to be between tags or at the end is held back, so the
+  content of the spaceless tag is never buffered as a whole.
+*/
+class SpacelessDevice : public QIODevice
+{
+public:
+  explicit SpacelessDevice(OutputStream *stream) : m_stream(stream)
+  {
+    open(QIODevice::WriteOnly);
+  }
+
+protected:
+  qint64 readData(char *data, qint64 maxSize) override
+  {
+    Q_UNUSED(data)
+    Q_UNUSED(maxSize)
+    return -1;
+  }
+
+  qint64 writeData(const char *data, qint64 size) override
+  {
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+    const auto text = m_decoder.toUnicode(data, int(size));
+#else
+    const QString text = m_decoder.decode(QByteArrayView(data, size));
+#endif
+    collapse(text.constData(), text.size());
+    return size;
+  }
+
+private:
+  void write(const QChar *data, int size)
+  {
+    if (size > 0)
+      (*m_stream) << QString::fromRawData(data, size);
+  }
+
+  void collapse(const QChar *data, int size);
+
+  OutputStream *const m_stream;
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+  QTextDecoder m_decoder{QTextCodec::codecForName("UTF-8")};
+#else
+  QStringDecoder m_decoder{QStringDecoder::Utf8};
+#endif
+  // The whitespace at the end of the text so far, after some other text.
+  QString m_pendingSpace;
+  // Whether any text other than whitespace has been written.
+  bool m_started = false;
+  // Whether the last character other than whitespace was the end of a tag.
+  bool m_afterTag = false;
+};
+
+void SpacelessDevice::collapse(const QChar *data, int size)
+{
+  // A run of whitespace continued from the previous text ends here.
+  if (!m_pendingSpace.isEmpty() && size > 0 && !data[0].isSpace()) {
+    if (!(m_afterTag && data[0] == QLatin1Char('<')
+          && isAsciiSpace(m_pendingSpace.constData(), m_pendingSpace.size())))
+      write(m_pendingSpace.constData(), m_pendingSpace.size());
+    m_pendingSpace.clear();
+  }
+
+  auto written = 0;
+  auto i = 0;
+  while (i < size) {
+    if (!data[i].isSpace()) {
+      m_started = true;
+      m_afterTag = data[i] == QLatin1Char('>');
+      ++i;
+      continue;
+    }
+
+    const auto runStart = i;
+    while (i < size && data[i].isSpace())
+      ++i;
+    write(data + written, runStart - written);
+    written = i;
+
+    if (!m_started)
+      continue;
+    if (i == size) {
+      m_pendingSpace.append(data + runStart, i - runStart);
+    } else {
+      m_pendingSpace.append(data + runStart, i - runStart);
+      if (!(m_afterTag && data[i] == QLatin1Char('<')
+            && isAsciiSpace(m_pendingSpace.constData(),
+                            m_pendingSpace.size())))
+        write(m_pendingSpace.constData(), m_pendingSpace.size());
+      m_pendingSpace.clear();
+    }
+  }
+  write(data + written, size - written);
+}
+}
 
 SpacelessNodeFactory::SpacelessNodeFactory() = default;
 
@@ -41,20 +167,18 @@ SpacelessNode::SpacelessNode(const Grantlee::Token &token, QObject *parent) : No
 
 void SpacelessNode::setList(const NodeList &nodeList) { m_nodeList = nodeList; }
 
-QString SpacelessNode::stripSpacesBetweenTags(const QString &input)
-{
-  auto stripped = input;
-
-  static const QRegularExpression re(QStringLiteral(">\\s+<"));
-  stripped.replace(re, QStringLiteral("><"));
-  return stripped;
-}
-
 void SpacelessNode::render(OutputStream *stream, Context *c) const
 {
-  QString output;
-  QTextStream textStream(&output);
+  // The content is written through the device as it is rendered, so only the
+  // buffer of the text stream is held in memory.
+  SpacelessDevice device(stream);
+  QTextStream textStream(&device);
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+  textStream.setCodec("UTF-8");
+#else
+  textStream.setEncoding(QStringConverter::Utf8);
+#endif
   auto temp = stream->clone(&textStream);
   m_nodeList.render(temp.data(), c);
-  (*stream) << markSafe(stripSpacesBetweenTags(output.trimmed()));
+  textStream.flush();
 }
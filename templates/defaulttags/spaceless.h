@@ -45,8 +45,6 @@ public:
   void render(OutputStream *stream, Context *c) const override;
 
 private:
-  static QString stripSpacesBetweenTags(const QString &input);
-
   NodeList m_nodeList;
 };
 
@@ -20,6 +20,8 @@
 
 #include "cachingloaderdecorator.h"
 
+#include <QtCore/QMutex>
+
 namespace Grantlee
 {
 
@@ -37,6 +39,8 @@ public:
 
   const QSharedPointer<AbstractTemplateLoader> m_wrappedLoader;
 
+  // Templates may be loaded while rendering on several threads.
+  mutable QMutex m_mutex;
   mutable QHash<QString, Template> m_cache;
 };
 }
@@ -60,18 +64,21 @@ bool CachingLoaderDecorator::canLoadTemplate(const QString &name) const
 void CachingLoaderDecorator::clear()
 {
   Q_D(CachingLoaderDecorator);
+  QMutexLocker locker(&d->m_mutex);
   return d->m_cache.clear();
 }
 
 int CachingLoaderDecorator::size() const
 {
   Q_D(const CachingLoaderDecorator);
+  QMutexLocker locker(&d->m_mutex);
   return d->m_cache.size();
 }
 
 bool CachingLoaderDecorator::isEmpty() const
 {
   Q_D(const CachingLoaderDecorator);
+  QMutexLocker locker(&d->m_mutex);
   return d->m_cache.isEmpty();
 }
 
@@ -87,13 +94,22 @@ CachingLoaderDecorator::loadByName(const QString &name,
                                    const Grantlee::Engine *engine) const
 {
   Q_D(const CachingLoaderDecorator);
-  const auto it = d->m_cache.constFind(name);
-  if (it != d->m_cache.constEnd()) {
-    return it.value();
+  {
+    QMutexLocker locker(&d->m_mutex);
+    const auto it = d->m_cache.constFind(name);
+    if (it != d->m_cache.constEnd()) {
+      return it.value();
+    }
   }
 
+  // The template is compiled without the lock. If another thread compiled it
+  // meanwhile, its template is kept.
   const auto t = d->m_wrappedLoader->loadByName(name, engine);
 
+  QMutexLocker locker(&d->m_mutex);
+  const auto it = d->m_cache.constFind(name);
+  if (it != d->m_cache.constEnd())
+    return it.value();
   d->m_cache.insert(name, t);
 
   return t;
@@ -21,13 +21,52 @@
 #include "context.h"
 
 #include "nulllocalizer_p.h"
+#include "forwarditerable_p.h"
 #include "rendercontext.h"
 #include "util.h"
 
+#include <QtCore/QSet>
 #include <QtCore/QStringList>
 
 using namespace Grantlee;
 
+namespace Grantlee
+{
+using LazyFunction = QSharedPointer<const std::function<QVariant()>>;
+
+/**
+  @internal The value stored in the Context by Context::lazyValue.
+*/
+struct LazyContextValue {
+  LazyFunction function;
+};
+}
+
+Q_DECLARE_METATYPE(Grantlee::LazyContextValue)
+
+// Strings are always looked up as Grantlee::SafeString, so they are
+// converted once when inserted instead of on every lookup.
+static QVariant toContextValue(const QVariant &variant)
+{
+  if (variant.userType() == qMetaTypeId<QString>())
+    return QVariant::fromValue<Grantlee::SafeString>(
+        getSafeString(variant.value<QString>()));
+  return variant;
+}
+
+// Converts the strings of @p hash and returns the names of those values.
+static QSet<QString> toContextHash(QVariantHash *hash)
+{
+  QSet<QString> strings;
+  for (auto it = hash->begin(), end = hash->end(); it != end; ++it) {
+    if (it.value().userType() == qMetaTypeId<QString>()) {
+      it.value() = toContextValue(it.value());
+      strings.insert(it.key());
+    }
+  }
+  return strings;
+}
+
 namespace Grantlee
 {
 class ContextPrivate
@@ -35,17 +74,39 @@ class ContextPrivate
   ContextPrivate(Context *context, const QVariantHash &variantHash)
       : q_ptr(context), m_autoescape(true), m_mutating(false),
         m_urlType(Context::AbsoluteUrls), m_renderContext(new RenderContext),
-        m_localizer(new NullLocalizer)
+        m_localizer(new NullLocalizer), m_lookupRecorder(nullptr),
+        m_insertRecorder(nullptr), m_recordedDepth(0)
   {
-    m_variantHashStack.append(variantHash);
+    auto hash = variantHash;
+    m_stringNamesStack.append(toContextHash(&hash));
+    m_variantHashStack.append(hash);
   }
 
   ~ContextPrivate() { delete m_renderContext; }
 
+  void recordInsert(const QString &name)
+  {
+    if (m_insertRecorder && m_variantHashStack.size() == m_recordedDepth)
+      m_insertRecorder->insert(name);
+  }
+
+  void insert(const QString &name, const QVariant &variant)
+  {
+    recordInsert(name);
+    if (variant.userType() == qMetaTypeId<QString>())
+      m_stringNamesStack[0].insert(name);
+    else
+      m_stringNamesStack[0].remove(name);
+    m_variantHashStack[0].insert(name, toContextValue(variant));
+  }
+
   Q_DECLARE_PUBLIC(Context)
   Context *const q_ptr;
 
   QList<QVariantHash> m_variantHashStack;
+  // The names in each hash of m_variantHashStack whose value was inserted as
+  // a QString, so that Context::stackHash can return them as they were given.
+  QList<QSet<QString>> m_stringNamesStack;
   bool m_autoescape;
   bool m_mutating;
   QList<QPair<QString, QString>> m_externalMedia;
@@ -53,6 +114,15 @@ class ContextPrivate
   QString m_relativeMediaPath;
   RenderContext *const m_renderContext;
   QSharedPointer<AbstractLocalizer> m_localizer;
+  // The results of the lazy values computed in the current render, keyed by
+  // their function, which is also kept alive by the hash.
+  mutable QHash<const std::function<QVariant()> *, QPair<LazyFunction, QVariant>>
+      m_lazyResults;
+  QSet<QString> *m_lookupRecorder;
+  QSet<QString> *m_insertRecorder;
+  // The depth of the stack when recording started. Names inserted deeper are
+  // removed again by a pop before the recording ends.
+  int m_recordedDepth;
 };
 }
 
@@ -77,6 +147,7 @@ Context &Context::operator=(const Context &other)
   d_ptr->m_externalMedia = other.d_ptr->m_externalMedia;
   d_ptr->m_mutating = other.d_ptr->m_mutating;
   d_ptr->m_variantHashStack = other.d_ptr->m_variantHashStack;
+  d_ptr->m_stringNamesStack = other.d_ptr->m_stringNamesStack;
   d_ptr->m_urlType = other.d_ptr->m_urlType;
   d_ptr->m_relativeMediaPath = other.d_ptr->m_relativeMediaPath;
   return *this;
@@ -100,30 +171,113 @@ QVariant Context::lookup(const QString &str) const
 {
   Q_D(const Context);
 
+  if (d->m_lookupRecorder)
+    d->m_lookupRecorder->insert(str);
+
   // return a variant from the stack.
   for (const auto &h : d->m_variantHashStack) {
     auto it = h.constFind(str);
-    if (it != h.constEnd()) {
-      auto var = it.value();
-      // If the user passed a string into the context, turn it into a
-      // Grantlee::SafeString.
-      if (var.userType() == qMetaTypeId<QString>()) {
-        var = QVariant::fromValue<Grantlee::SafeString>(
-            getSafeString(var.value<QString>()));
-      }
-      return var;
-    }
+    if (it != h.constEnd())
+      return resolveLazyValue(it.value());
   }
 
   return {};
 }
 
+void Context::setLookupRecorder(QSet<QString> *lookups,
+                                QSet<QString> *insertions)
+{
+  Q_D(Context);
+  d->m_lookupRecorder = lookups;
+  d->m_insertRecorder = insertions;
+  d->m_recordedDepth = d->m_variantHashStack.size();
+}
+
+void Context::recordLookupPath(const QStringList &lookups) const
+{
+  Q_D(const Context);
+  if (d->m_lookupRecorder && lookups.size() > 1)
+    d->m_lookupRecorder->insert(lookups.join(QLatin1Char('.')));
+}
+
+QVariant Context::lazyValue(const std::function<QVariant()> &function)
+{
+  return QVariant::fromValue(
+      LazyContextValue{LazyFunction(new std::function<QVariant()>(function))});
+}
+
+QVariant Context::forwardIterable(
+    const std::function<std::function<bool(QVariant &)>()> &begin, int size)
+{
+  ForwardIterable iterable;
+  iterable.begin = QSharedPointer<const ForwardIterable::BeginFunction>(
+      new ForwardIterable::BeginFunction(begin));
+  iterable.size = size;
+  return QVariant::fromValue(iterable);
+}
+
+void Context::insertLazy(const QString &name,
+                         const std::function<QVariant()> &function)
+{
+  Q_D(Context);
+
+  d->insert(name, lazyValue(function));
+}
+
+QVariant Context::resolveLazyValue(const QVariant &variant) const
+{
+  Q_D(const Context);
+
+  if (variant.userType() != qMetaTypeId<LazyContextValue>())
+    return variant;
+
+  const auto function
+      = static_cast<const LazyContextValue *>(variant.constData())->function;
+  const auto it = d->m_lazyResults.constFind(function.data());
+  if (it != d->m_lazyResults.constEnd())
+    return it->second;
+
+  const auto result = toContextValue((*function)());
+  d->m_lazyResults.insert(function.data(), qMakePair(function, result));
+  return result;
+}
+
+void Context::resetLazyValues()
+{
+  Q_D(Context);
+  d->m_lazyResults.clear();
+}
+
+QStringList Context::untouchedLazyValues() const
+{
+  Q_D(const Context);
+
+  QStringList names;
+  QSet<QString> seen;
+  for (const auto &h : d->m_variantHashStack) {
+    for (auto it = h.constBegin(), end = h.constEnd(); it != end; ++it) {
+      if (seen.contains(it.key()))
+        continue;
+      seen.insert(it.key());
+      if (it.value().userType() != qMetaTypeId<LazyContextValue>())
+        continue;
+      const auto function
+          = static_cast<const LazyContextValue *>(it.value().constData())
+                ->function;
+      if (!d->m_lazyResults.contains(function.data()))
+        names.append(it.key());
+    }
+  }
+  return names;
+}
+
 void Context::push()
 {
   Q_D(Context);
 
   const QHash<QString, QVariant> hash;
   d->m_variantHashStack.prepend(hash);
+  d->m_stringNamesStack.prepend(QSet<QString>());
 }
 
 void Context::pop()
@@ -131,27 +285,35 @@ void Context::pop()
   Q_D(Context);
 
   d->m_variantHashStack.removeFirst();
+  d->m_stringNamesStack.removeFirst();
 }
 
 void Context::insert(const QString &name, const QVariant &variant)
 {
   Q_D(Context);
 
-  d->m_variantHashStack[0].insert(name, variant);
+  d->insert(name, variant);
 }
 
 void Context::insert(const QString &name, QObject *object)
 {
   Q_D(Context);
 
-  d->m_variantHashStack[0].insert(name, QVariant::fromValue(object));
+  d->insert(name, QVariant::fromValue(object));
 }
 
 QHash<QString, QVariant> Context::stackHash(int depth) const
 {
   Q_D(const Context);
 
-  return d->m_variantHashStack.value(depth);
+  auto hash = d->m_variantHashStack.value(depth);
+  // Give back the strings which were converted when inserted.
+  for (const auto &name : d->m_stringNamesStack.value(depth)) {
+    auto &value = hash[name];
+    value = QString(
+        static_cast<const Grantlee::SafeString *>(value.constData())->get());
+  }
+  return hash;
 }
 
 bool Context::isMutating() const
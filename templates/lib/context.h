@@ -24,8 +24,12 @@
 #include "abstractlocalizer.h"
 #include "grantlee_templates_export.h"
 
+#include <QtCore/QSet>
+#include <QtCore/QStringList>
 #include <QtCore/QVariantHash>
 
+#include <functional>
+
 namespace Grantlee
 {
 
@@ -63,6 +67,19 @@ class ContextPrivate;
   commonly, QObjects will be used here.
   @see @ref custom_objects
 
+  Values which are expensive to compute may be inserted with @ref insertLazy.
+  They are only computed if the Template looks them up while rendering.
+
+  @code
+    Context c;
+    c.insertLazy( "report", [] { return QVariant::fromValue( loadReport() ); } );
+
+    t->render( &c );
+
+    // The names of the lazy values the template did not need.
+    qDebug() << c.untouchedLazyValues();
+  @endcode
+
   @section context_stack Context Stack.
 
   For template tag developers, some other **%Context** API is relevant.
@@ -176,6 +193,59 @@ public:
   */
   void insert(const QString &name, const QVariant &variant);
 
+  /**
+    Insert a lazily computed value identified by @p name into the
+    **%Context**.
+
+    @p function is called the first time @p name is looked up while rendering,
+    and its result is reused for the rest of that render.
+  */
+  void insertLazy(const QString &name,
+                  const std::function<QVariant()> &function);
+
+  /**
+    Returns a value which calls @p function the first time it is looked up
+    while rendering. Unlike @ref insertLazy, this may be nested in containers
+    such as a QVariantHash, for example to compute one property of a
+    context object only when it is used.
+  */
+  static QVariant lazyValue(const std::function<QVariant()> &function);
+
+  /**
+    Returns a value which is iterated by calling the function returned by
+    @p begin until it returns false. Each call stores the next item in its
+    argument. @p begin is called again each time the value is iterated.
+
+    The @gr_tag{for} tag renders each item as it is produced, so that rows
+    streamed from a database cursor are never all held in memory.
+
+    @code
+      c.insert( "rows", Grantlee::Context::forwardIterable( [] {
+        auto query = QSharedPointer<QSqlQuery>::create( "SELECT * FROM rows" );
+        return [query]( QVariant &row ) {
+          if ( !query->next() )
+            return false;
+          row = QVariantList{ query->value( 0 ), query->value( 1 ) };
+          return true;
+        };
+      } ) );
+    @endcode
+
+    If the number of items is known in advance, it may be passed as @p size
+    to make <tt>forloop.revcounter</tt> available in loops. Filters and
+    tags other than @gr_tag{for}, and reversed loops, convert the value to a
+    list first.
+  */
+  static QVariant
+  forwardIterable(const std::function<std::function<bool(QVariant &)>()> &begin,
+                  int size = -1);
+
+  /**
+    Returns the names of the lazy values in the **%Context** which were not
+    computed during the last render.
+  */
+  QStringList untouchedLazyValues() const;
+
   /**
     Pushes a new context.
     @see @ref context_stack
@@ -216,6 +286,35 @@ public:
     @internal
   */
   void clearExternalMedia();
+
+  /**
+    @internal
+    Returns the result of @p variant if it is a lazy value, and @p variant
+    otherwise.
+  */
+  QVariant resolveLazyValue(const QVariant &variant) const;
+
+  /**
+    @internal
+    Forgets the results of lazy values computed in a previous render.
+  */
+  void resetLazyValues();
+
+  /**
+    @internal
+    Records the names passed to @ref lookup and the paths passed to
+    @ref recordLookupPath into @p lookups, and the names inserted at the
+    current depth of the stack into @p insertions. Recording stops if
+    @p lookups is null.
+  */
+  void setLookupRecorder(QSet<QString> *lookups,
+                         QSet<QString> *insertions = nullptr);
+
+  /**
+    @internal
+    Records the lookup path @p lookups of a variable, if recording.
+  */
+  void recordLookupPath(const QStringList &lookups) const;
 #endif
 
   /**
@@ -22,6 +22,7 @@
 #include "customtyperegistry_p.h"
 
 #include "metaenumvariable_p.h"
+#include "modelrows_p.h"
 #include "safestring.h"
 
 #include <QtCore/QLoggingCategory>
@@ -33,18 +34,58 @@ Q_LOGGING_CATEGORY(GRANTLEE_CUSTOMTYPE, "grantlee.customtype")
 
 using namespace Grantlee;
 
-CustomTypeRegistry::CustomTypeRegistry()
+CustomTypeRegistry::Page::Page()
+{
+  for (auto &function : functions)
+    function.store(nullptr, std::memory_order_relaxed);
+}
+
+CustomTypeRegistry::CustomTypeRegistry() : m_pages(nullptr)
 {
   // Grantlee Types
   registerBuiltInMetatype<SafeString>();
   registerBuiltInMetatype<MetaEnumVariable>();
+
+  // Qt Types
+  registerBuiltInMetatype<QModelIndex>();
+  registerBuiltInMetatype<ModelRows>();
 }
 
+CustomTypeRegistry::~CustomTypeRegistry() = default;
+
 void CustomTypeRegistry::registerLookupOperator(int id,
                                                 MetaType::LookupFunction f)
 {
-  CustomTypeInfo &info = types[id];
-  info.lookupFunction = f;
+  const auto slot = typeSlot(id);
+  const auto pageIndex = std::size_t(slot / PageSize);
+  auto pages = m_pages.load(std::memory_order_relaxed);
+  if (!pages || pageIndex >= pages->size() || !(*pages)[pageIndex]) {
+    std::unique_ptr<PageTable> table(pages ? new PageTable(*pages)
+                                           : new PageTable);
+    if (pageIndex >= table->size())
+      table->resize(pageIndex + 1, nullptr);
+    m_pageStorage.emplace_back(new Page);
+    (*table)[pageIndex] = m_pageStorage.back().get();
+
+    pages = table.get();
+    m_pages.store(pages, std::memory_order_release);
+    m_pageTables.push_back(std::move(table));
+  }
+  (*pages)[pageIndex]->functions[slot % PageSize].store(
+      f, std::memory_order_release);
+}
+
+MetaType::LookupFunction CustomTypeRegistry::lookupFunction(int id) const
+{
+  const auto pages = m_pages.load(std::memory_order_acquire);
+  const auto slot = typeSlot(id);
+  if (!pages || slot < 0)
+    return nullptr;
+  const auto pageIndex = std::size_t(slot / PageSize);
+  if (pageIndex >= pages->size() || !(*pages)[pageIndex])
+    return nullptr;
+  return (*pages)[pageIndex]->functions[slot % PageSize].load(
+      std::memory_order_acquire);
 }
 
 QVariant CustomTypeRegistry::lookup(const QVariant &object,
@@ -53,45 +94,23 @@ QVariant CustomTypeRegistry::lookup(const QVariant &object,
   if (!object.isValid())
     return {};
   const auto id = object.userType();
-  MetaType::LookupFunction lf;
-
-  {
-    auto it = types.constFind(id);
-    if (it == types.constEnd()) {
-      qCWarning(GRANTLEE_CUSTOMTYPE) << "Don't know how to handle metatype"
-#if QT_VERSION < QT_VERSION_CHECK(5, 15, 0)
-                                     << QMetaType::typeName(id);
-#else
-                                     << QMetaType(id).name();
-#endif
-      // :TODO: Print out error message
-      return {};
-    }
 
-    const CustomTypeInfo &info = it.value();
-    if (!info.lookupFunction) {
-      qCWarning(GRANTLEE_CUSTOMTYPE) << "No lookup function for metatype"
+  const auto function = lookupFunction(id);
+  if (!function) {
+    qCWarning(GRANTLEE_CUSTOMTYPE) << "Don't know how to handle metatype"
 #if QT_VERSION < QT_VERSION_CHECK(5, 15, 0)
-                                     << QMetaType::typeName(id);
+                                   << QMetaType::typeName(id);
 #else
-                                     << QMetaType(id).name();
+                                   << QMetaType(id).name();
 #endif
-      lf = nullptr;
-      // :TODO: Print out error message
-      return {};
-    }
-
-    lf = info.lookupFunction;
+    // :TODO: Print out error message
+    return {};
   }
 
-  return lf(object, property);
+  return function(object, property);
 }
 
 bool CustomTypeRegistry::lookupAlreadyRegistered(int id) const
 {
-  auto it = types.constFind(id);
-  if (it != types.constEnd()) {
-    return it.value().lookupFunction != nullptr;
-  }
-  return false;
+  return lookupFunction(id) != nullptr;
 }
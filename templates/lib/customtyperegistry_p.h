@@ -26,18 +26,16 @@
 
 #include <QtCore/QMutex>
 
+#include <atomic>
+#include <memory>
+#include <vector>
+
 namespace Grantlee
 {
 
-struct CustomTypeInfo {
-public:
-  CustomTypeInfo() : lookupFunction(nullptr) {}
-
-  Grantlee::MetaType::LookupFunction lookupFunction;
-};
-
 struct CustomTypeRegistry {
   CustomTypeRegistry();
+  ~CustomTypeRegistry();
 
   void registerLookupOperator(int id, MetaType::LookupFunction f);
 
@@ -61,8 +59,40 @@ struct CustomTypeRegistry {
   QVariant lookup(const QVariant &object, const QString &property) const;
   bool lookupAlreadyRegistered(int id) const;
 
-  QHash<int, CustomTypeInfo> types;
+  // Built-in metatype ids are below QMetaType::User and user ids start
+  // there, so the user ids are moved down to follow the built-in ones.
+  static int typeSlot(int id)
+  {
+    if (id < QMetaType::User)
+      return id;
+    return id - QMetaType::User + QMetaType::HighestInternalId + 1;
+  }
+
   QMutex mutex;
+
+private:
+  enum { PageSize = 64 };
+
+  struct Page {
+    Page();
+
+    std::atomic<MetaType::LookupFunction> functions[PageSize];
+  };
+
+  using PageTable = std::vector<Page *>;
+
+  MetaType::LookupFunction lookupFunction(int id) const;
+
+  // The lookup functions, in pages of PageSize slots indexed by the slot of
+  // their metatype id. Pages are only allocated for the slots in use, and are
+  // never moved or freed, so lookups read them without locking. Registration,
+  // which holds the mutex, stores the function in its slot, and only copies
+  // the table of pages when it needs a new page. Replaced tables are kept
+  // until the registry is destroyed, as a lookup may still be reading them,
+  // but they only hold a pointer per page.
+  std::atomic<const PageTable *> m_pages;
+  std::vector<std::unique_ptr<const PageTable>> m_pageTables;
+  std::vector<std::unique_ptr<Page>> m_pageStorage;
 };
 }
 
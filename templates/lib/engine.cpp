@@ -31,9 +31,24 @@
 #include "templateloader.h"
 
 #include <QtCore/QCoreApplication>
+#include <QtCore/QCryptographicHash>
 #include <QtCore/QDir>
+#include <QtCore/QFileInfo>
 #include <QtCore/QPluginLoader>
+#include <QtCore/QRunnable>
 #include <QtCore/QTextStream>
+#include <QtCore/QTimer>
+#include <QtCore/QtPlugin>
+
+// Generated by moc for the plugins compiled with QT_STATICPLUGIN.
+#ifdef GRANTLEE_STATIC_MAIN_PLUGINS
+extern const QStaticPlugin qt_static_plugin_DefaultTagLibrary();
+extern const QStaticPlugin qt_static_plugin_LoaderTagLibrary();
+extern const QStaticPlugin qt_static_plugin_DefaultFiltersLibrary();
+#endif
+#ifdef GRANTLEE_STATIC_I18N_PLUGIN
+extern const QStaticPlugin qt_static_plugin_I18nTagLibrary();
+#endif
 
 using namespace Grantlee;
 
@@ -48,13 +63,30 @@ Engine::Engine(QObject *parent)
 
   d_ptr->m_pluginDirs = QCoreApplication::libraryPaths();
   d_ptr->m_pluginDirs << QString::fromLocal8Bit(GRANTLEE_PLUGIN_PATH);
+
+#ifdef GRANTLEE_STATIC_MAIN_PLUGINS
+  addStaticLibrary(QStringLiteral("grantlee_defaulttags"),
+                   qt_static_plugin_DefaultTagLibrary().instance());
+  addStaticLibrary(QStringLiteral("grantlee_loadertags"),
+                   qt_static_plugin_LoaderTagLibrary().instance());
+  addStaticLibrary(QStringLiteral("grantlee_defaultfilters"),
+                   qt_static_plugin_DefaultFiltersLibrary().instance());
+#endif
+#ifdef GRANTLEE_STATIC_I18N_PLUGIN
+  addStaticLibrary(QStringLiteral("grantlee_i18ntags"),
+                   qt_static_plugin_I18nTagLibrary().instance());
+#endif
 }
 
 Engine::~Engine()
 {
+  // A reload in progress uses the loaders and libraries.
+  d_ptr->m_reloadPool.waitForDone();
 #ifdef QT_QML_LIB
   qDeleteAll(d_ptr->m_scriptableLibraries);
 #endif
+  // The nodes of the loaded templates may be implemented in the plugins.
+  d_ptr->m_generation.clear();
   d_ptr->m_libraries.clear();
   delete d_ptr;
 }
@@ -71,6 +103,18 @@ void Engine::addTemplateLoader(QSharedPointer<AbstractTemplateLoader> loader)
   d->m_loaders << loader;
 }
 
+void Engine::setFragmentCache(QSharedPointer<AbstractFragmentCache> cache)
+{
+  Q_D(Engine);
+  d->m_fragmentCache = cache;
+}
+
+QSharedPointer<AbstractFragmentCache> Engine::fragmentCache() const
+{
+  Q_D(const Engine);
+  return d->m_fragmentCache;
+}
+
 QPair<QString, QString> Engine::mediaUri(const QString &fileName) const
 {
   Q_D(const Engine);
@@ -111,6 +155,15 @@ QStringList Engine::pluginPaths() const
   return d->m_pluginDirs;
 }
 
+void Engine::addStaticLibrary(const QString &name, QObject *library)
+{
+  Q_D(Engine);
+  const auto plugin = PluginPointer<TagLibraryInterface>(library);
+  Q_ASSERT(plugin.data());
+  QMutexLocker locker(&d->m_libraryMutex);
+  d->m_libraries.insert(name, plugin);
+}
+
 QStringList Engine::defaultLibraries() const
 {
   Q_D(const Engine);
@@ -140,6 +193,8 @@ void Engine::loadDefaultLibraries()
 {
   Q_D(Engine);
 
+  QMutexLocker locker(&d->m_libraryMutex);
+
 #ifdef QT_QML_LIB
   // Make sure we can load default scriptable libraries if we're supposed to.
   if (d->m_defaultLibraries.contains(QLatin1String(s_scriptableLibName))
@@ -197,6 +252,8 @@ TagLibraryInterface *Engine::loadLibrary(const QString &name)
 {
   Q_D(Engine);
 
+  QMutexLocker locker(&d->m_libraryMutex);
+
 #ifdef QT_QML_LIB
   if (name == QLatin1String(s_scriptableLibName))
     return nullptr;
@@ -245,8 +302,9 @@ EnginePrivate::EnginePrivate(Engine *engine)
       m_scriptableTagLibrary(nullptr)
 #endif
       ,
-      m_smartTrimEnabled(false)
+      m_smartTrimEnabled(false), m_reloadTimer(nullptr)
 {
+  m_reloadPool.setMaxThreadCount(1);
 }
 
 QString EnginePrivate::getScriptLibraryName(const QString &name,
@@ -362,27 +420,276 @@ EnginePrivate::loadCppLibrary(const QString &name, uint minorVersion)
   return nullptr;
 }
 
-Template Engine::loadByName(const QString &name) const
+static bool readSource(TemplateSource *source)
 {
-  Q_D(const Engine);
+  const QFileInfo info(source->path);
+  source->lastModified = info.lastModified();
+  source->size = info.size();
+
+  QFile file(source->path);
+  if (!file.open(QIODevice::ReadOnly))
+    return false;
+  source->hash
+      = QCryptographicHash::hash(file.readAll(), QCryptographicHash::Sha1);
+  return true;
+}
 
-  for (auto &loader : d->m_loaders) {
+Template EnginePrivate::loadTemplate(const QString &name,
+                                     TemplateSource *source) const
+{
+  Q_Q(const Engine);
+
+  for (auto &loader : m_loaders) {
     if (!loader->canLoadTemplate(name))
       continue;
 
-    const auto t = loader->loadByName(name, this);
+    // The source is read before it is compiled. If it changes in between,
+    // the next reload compiles it again, instead of missing the change.
+    if (source) {
+      const auto uri = loader->getMediaUri(name);
+      *source = TemplateSource();
+      source->path = uri.first + uri.second;
+      if (!source->path.isEmpty())
+        readSource(source);
+    }
 
-    if (t) {
+    const auto t = loader->loadByName(name, q);
+
+    if (t)
       return t;
-    }
   }
-  auto t = Template(new TemplateImpl(this));
+  if (source)
+    *source = TemplateSource();
+  auto t = Template(new TemplateImpl(q));
   t->setObjectName(name);
   t->d_ptr->m_error = TagSyntaxError;
   t->d_ptr->m_errorString = QStringLiteral("Template not found, %1").arg(name);
   return t;
 }
 
+Template Engine::loadByName(const QString &name) const
+{
+  Q_D(const Engine);
+
+  // Use the generation of the template being rendered, if any, so that the
+  // templates it includes or extends are consistent with it.
+  auto generation = TemplateGenerationScope::current(this);
+  if (!generation) {
+    QMutexLocker locker(&d->m_loaderMutex);
+    generation = d->m_generation;
+  }
+  if (!generation)
+    return d->loadTemplate(name, nullptr);
+
+  {
+    QMutexLocker locker(&d->m_loaderMutex);
+    const auto it = generation->templates.constFind(name);
+    if (it != generation->templates.constEnd())
+      return it.value();
+  }
+
+  // The template is compiled without the lock, so another thread may load it
+  // at the same time. The first one to finish is kept.
+  TemplateSource source;
+  const auto t = d->loadTemplate(name, &source);
+  // Templates without a source file are kept and never reloaded, unless they
+  // failed to load, so that a missing template is looked for again.
+  if (source.path.isEmpty() && t->error() != NoError)
+    return t;
+
+  QMutexLocker locker(&d->m_loaderMutex);
+  const auto it = generation->templates.constFind(name);
+  if (it != generation->templates.constEnd())
+    return it.value();
+
+  t->d_ptr->m_generation = generation;
+  generation->templates.insert(name, t);
+  if (!source.hash.isNull())
+    generation->sources.insert(name, source);
+  return t;
+}
+
+void Engine::setTemplateReloadingEnabled(bool enabled, int interval)
+{
+  Q_D(Engine);
+
+  QMutexLocker locker(&d->m_loaderMutex);
+
+  if (!enabled) {
+    delete d->m_reloadTimer;
+    d->m_reloadTimer = nullptr;
+    d->m_generation.clear();
+    d->m_reloading.storeRelease(0);
+    return;
+  }
+
+  if (!d->m_generation) {
+    d->m_generation = QSharedPointer<TemplateGeneration>::create();
+    d->m_generation->engine = this;
+    d->m_generation->number = 0;
+    d->m_reloading.storeRelease(1);
+  }
+
+  if (!d->m_reloadTimer) {
+    d->m_reloadTimer = new QTimer(this);
+    connect(d->m_reloadTimer, &QTimer::timeout, this,
+            [d] { d->scheduleReload(); });
+  }
+  d->m_reloadTimer->start(interval);
+}
+
+bool Engine::templateReloadingEnabled() const
+{
+  Q_D(const Engine);
+  QMutexLocker locker(&d->m_loaderMutex);
+  return !d->m_generation.isNull();
+}
+
+int Engine::templateGeneration() const
+{
+  Q_D(const Engine);
+  QMutexLocker locker(&d->m_loaderMutex);
+  return d->m_generation ? d->m_generation->number : 0;
+}
+
+namespace
+{
+class ReloadJob : public QRunnable
+{
+public:
+  explicit ReloadJob(Engine *engine, QAtomicInt *scheduled)
+      : m_engine(engine), m_scheduled(scheduled)
+  {
+  }
+
+  void run() override
+  {
+    m_engine->reloadChangedTemplates();
+    m_scheduled->storeRelease(0);
+  }
+
+private:
+  Engine *const m_engine;
+  QAtomicInt *const m_scheduled;
+};
+}
+
+void EnginePrivate::scheduleReload()
+{
+  Q_Q(Engine);
+
+  // A slow reload is not queued again on each tick of the timer.
+  if (!m_reloadScheduled.testAndSetAcquire(0, 1))
+    return;
+  m_reloadPool.start(new ReloadJob(q, &m_reloadScheduled));
+}
+
+void Engine::reloadChangedTemplates()
+{
+  Q_D(Engine);
+
+  QHash<QString, TemplateSource> sources;
+  {
+    QMutexLocker locker(&d->m_loaderMutex);
+    if (!d->m_generation)
+      return;
+    sources = d->m_generation->sources;
+  }
+
+  // Compile the changed templates one at a time, so that renders on other
+  // threads can go on loading from the current generation in between.
+  QHash<QString, Template> changedTemplates;
+  QHash<QString, TemplateSource> changedSources;
+  QStringList removed;
+  for (auto it = sources.constBegin(), end = sources.constEnd(); it != end;
+       ++it) {
+    const QFileInfo info(it->path);
+    if (info.exists() && info.lastModified() == it->lastModified
+        && info.size() == it->size)
+      continue;
+
+    TemplateSource source;
+    source.path = it->path;
+    if (!readSource(&source)) {
+      removed.append(it.key());
+      continue;
+    }
+    if (source.hash == it->hash)
+      continue;
+
+    const auto t = d->loadTemplate(it.key(), nullptr);
+    // The thread of a scheduled reload may end before the template is used.
+    t->moveToThread(thread());
+    changedTemplates.insert(it.key(), t);
+    changedSources.insert(it.key(), source);
+  }
+
+  if (changedTemplates.isEmpty() && removed.isEmpty())
+    return;
+
+  QMutexLocker locker(&d->m_loaderMutex);
+  if (!d->m_generation)
+    return;
+
+  // Templates which include or extend the changed ones are kept, as they
+  // load them by name while rendering, from their own generation.
+  auto generation = QSharedPointer<TemplateGeneration>::create(*d->m_generation);
+  ++generation->number;
+  for (const auto &name : qAsConst(removed)) {
+    generation->templates.remove(name);
+    generation->sources.remove(name);
+  }
+  for (auto it = changedTemplates.constBegin(), end = changedTemplates.constEnd();
+       it != end; ++it) {
+    generation->templates.insert(it.key(), it.value());
+    generation->sources.insert(it.key(), changedSources.value(it.key()));
+  }
+  for (const auto &t : qAsConst(generation->templates))
+    t->d_ptr->m_generation = generation;
+
+  d->m_generation = generation;
+}
+
+static thread_local TemplateGenerationScope *s_generationScope = nullptr;
+
+TemplateGenerationScope::TemplateGenerationScope(const TemplatePrivate *t)
+    : m_previous(s_generationScope)
+{
+  const auto engine = t->m_engine.data();
+  // Nested renders keep the generation of the outermost one.
+  if (!engine || current(engine))
+    return;
+
+  const auto d = engine->d_func();
+  if (!d->m_reloading.loadAcquire())
+    return;
+
+  QMutexLocker locker(&d->m_loaderMutex);
+  if (!d->m_generation)
+    return;
+
+  m_generation = t->m_generation.toStrongRef();
+  if (!m_generation)
+    m_generation = d->m_generation;
+  s_generationScope = this;
+}
+
+TemplateGenerationScope::~TemplateGenerationScope()
+{
+  if (m_generation)
+    s_generationScope = m_previous;
+}
+
+QSharedPointer<TemplateGeneration>
+TemplateGenerationScope::current(const Engine *engine)
+{
+  for (auto scope = s_generationScope; scope; scope = scope->m_previous) {
+    if (scope->m_generation->engine == engine)
+      return scope->m_generation;
+  }
+  return {};
+}
+
 Template Engine::newTemplate(const QString &content, const QString &name) const
 {
   Q_D(const Engine);
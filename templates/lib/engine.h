@@ -26,6 +26,7 @@
 
 namespace Grantlee
 {
+class AbstractFragmentCache;
 class TagLibraryInterface;
 
 class EnginePrivate;
@@ -142,6 +143,17 @@ public:
   */
   void addTemplateLoader(QSharedPointer<AbstractTemplateLoader> loader);
 
+  /**
+    Sets the @p cache used by the @gr_tag{cache} tag to store rendered
+    fragments. Without a cache, the tag renders its content every time.
+  */
+  void setFragmentCache(QSharedPointer<AbstractFragmentCache> cache);
+
+  /**
+    Returns the fragment cache configured on the **%Engine**, if any.
+  */
+  QSharedPointer<AbstractFragmentCache> fragmentCache() const;
+
   /**
     Sets the plugin dirs currently configured on the **%Engine** to @p dirs.
 
@@ -167,6 +179,24 @@ public:
   */
   QStringList pluginPaths() const;
 
+  /**
+    Makes the tag and filter library @p library available to new Templates
+    under the name @p name. Libraries added this way are used without
+    searching the plugin paths, and take precedence over plugins of the same
+    name found there.
+
+    The @p library must implement TagLibraryInterface, and it must outlive the
+    **%Engine**.
+
+    This is mostly useful for libraries linked statically into an application.
+    When %Grantlee is built with the <tt>GRANTLEE_STATIC_PLUGINS</tt> CMake
+    option, the libraries distributed with %Grantlee are added this way by the
+    constructor.
+
+    @see @ref finding_plugins
+  */
+  void addStaticLibrary(const QString &name, QObject *library);
+
   /**
     Returns a URI for a media item with the name @p name.
 
@@ -231,6 +261,46 @@ public:
    */
   void setSmartTrimEnabled(bool enabled);
 
+  /**
+    Sets whether Templates loaded with @ref loadByName are reloaded when
+    their source files change. The sources are checked every @p interval
+    milliseconds while the event loop of the thread of the **%Engine** runs.
+    The check and the compilation of changed Templates run on another thread,
+    so that they do not block that event loop.
+
+    Loaded Templates are kept in a generation. When sources change, the
+    changed Templates are compiled again and a new generation containing them
+    is published at once. Templates included or extended while rendering come
+    from the generation of the Template being rendered, so a render which has
+    started is not affected by a reload.
+
+    Templates can only be reloaded if their loader can tell where their source
+    is, as FileSystemTemplateLoader does through
+    AbstractTemplateLoader::getMediaUri. Other Templates, such as those of an
+    InMemoryTemplateLoader, are kept in the generation and never reloaded.
+
+    @note Do not combine this with a CachingLoaderDecorator, which would keep
+    returning the old Templates.
+  */
+  void setTemplateReloadingEnabled(bool enabled, int interval = 1000);
+
+  /**
+    Returns whether Templates are reloaded when their source files change.
+  */
+  bool templateReloadingEnabled() const;
+
+  /**
+    Returns the number of the current generation of Templates. It is
+    incremented each time changed Templates are published.
+  */
+  int templateGeneration() const;
+
+  /**
+    Checks the sources of the loaded Templates now on the calling thread, and
+    publishes a new generation if any of them changed.
+  */
+  void reloadChangedTemplates();
+
 #ifndef Q_QDOC
   /**
     @internal
@@ -253,6 +323,9 @@ public:
 private:
   Q_DECLARE_PRIVATE(Engine)
   EnginePrivate *const d_ptr;
+#ifndef Q_QDOC
+  friend class TemplateGenerationScope;
+#endif
 };
 }
 
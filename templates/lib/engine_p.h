@@ -23,15 +23,23 @@
 
 #include "engine.h"
 #include "filter.h"
+#include "fragmentcache.h"
 #include "pluginpointer_p.h"
 #include "taglibraryinterface.h"
 
+#include <QtCore/QAtomicInt>
+#include <QtCore/QDateTime>
+#include <QtCore/QMutex>
+#include <QtCore/QThreadPool>
+
 class QPluginLoader;
+class QTimer;
 
 namespace Grantlee
 {
 
 class ScriptableTagLibrary;
+class TemplatePrivate;
 
 class ScriptableLibraryContainer : public TagLibraryInterface
 {
@@ -80,6 +88,46 @@ private:
   QHash<QString, Filter *> m_filters;
 };
 
+/**
+  The file a Template was loaded from, and the state it had then. The hash is
+  null if the file could not be read.
+*/
+struct TemplateSource {
+  QString path;
+  QDateTime lastModified;
+  qint64 size;
+  QByteArray hash;
+};
+
+/**
+  A consistent set of Templates loaded by name. A new generation is published
+  when sources change, while renders which started earlier keep theirs.
+*/
+struct TemplateGeneration {
+  const Engine *engine;
+  int number;
+  QHash<QString, Template> templates;
+  QHash<QString, TemplateSource> sources;
+};
+
+/**
+  Makes the generation of the outermost Template being rendered on the thread
+  available to Engine::loadByName for the duration of the render.
+*/
+class TemplateGenerationScope
+{
+public:
+  explicit TemplateGenerationScope(const TemplatePrivate *t);
+  ~TemplateGenerationScope();
+
+  static QSharedPointer<TemplateGeneration> current(const Engine *engine);
+
+private:
+  Q_DISABLE_COPY(TemplateGenerationScope)
+  QSharedPointer<TemplateGeneration> m_generation;
+  TemplateGenerationScope *const m_previous;
+};
+
 class EnginePrivate
 {
   EnginePrivate(Engine *engine);
@@ -92,9 +140,12 @@ class EnginePrivate
 #endif
   PluginPointer<TagLibraryInterface> loadCppLibrary(const QString &name,
                                                     uint minorVersion);
+  Template loadTemplate(const QString &name, TemplateSource *source) const;
+  void scheduleReload();
 
   Q_DECLARE_PUBLIC(Engine)
   Engine *const q_ptr;
+  friend class TemplateGenerationScope;
 
   QHash<QString, PluginPointer<TagLibraryInterface>> m_libraries;
 #ifdef QT_QML_LIB
@@ -102,12 +153,30 @@ class EnginePrivate
 #endif
 
   QList<QSharedPointer<AbstractTemplateLoader>> m_loaders;
+  QSharedPointer<AbstractFragmentCache> m_fragmentCache;
+  // Guards the template generations. It is not held while templates are
+  // compiled, so that renders on several threads load templates in parallel.
+  mutable QMutex m_loaderMutex;
+  // Guards the loaded libraries, as templates compiled on several threads
+  // may load plugins.
+  mutable QMutex m_libraryMutex;
   QStringList m_pluginDirs;
   QStringList m_defaultLibraries;
 #ifdef QT_QML_LIB
   ScriptableTagLibrary *m_scriptableTagLibrary;
 #endif
   bool m_smartTrimEnabled;
+  QTimer *m_reloadTimer;
+  // Checks the sources and compiles the changed Templates off the thread of
+  // the Engine, one reload at a time.
+  QThreadPool m_reloadPool;
+  // Whether a reload has been started and not finished yet.
+  QAtomicInt m_reloadScheduled;
+  // Whether m_generation is set, readable without the lock.
+  QAtomicInt m_reloading;
+  // The current generation, or null if reloading is disabled. Guarded by
+  // m_loaderMutex, like the generations themselves.
+  QSharedPointer<TemplateGeneration> m_generation;
 };
 }
 
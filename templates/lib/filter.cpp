@@ -20,29 +20,77 @@
 
 #include "filter.h"
 
+#include "util.h"
+
 using namespace Grantlee;
 
+// Filters are shared by all renders of a template, so the stream they escape
+// with has to follow the rendering thread rather than the filter.
+static thread_local OutputStream *s_filterStream = nullptr;
+
 Filter::~Filter() = default;
 
-void Filter::setStream(Grantlee::OutputStream *stream) { m_stream = stream; }
+InPlaceFilter::~InPlaceFilter() = default;
+
+void Filter::setStream(Grantlee::OutputStream *stream) { s_filterStream = stream; }
 
 SafeString Filter::escape(const QString &input) const
 {
-  return m_stream->escape(input);
+  return s_filterStream->escape(input);
 }
 
 SafeString Filter::escape(const SafeString &input) const
 {
   if (input.isSafe())
-    return {m_stream->escape(input), SafeString::IsSafe};
-  return m_stream->escape(input);
+    return {s_filterStream->escape(input), SafeString::IsSafe};
+  return s_filterStream->escape(input);
 }
 
 SafeString Filter::conditionalEscape(const SafeString &input) const
 {
   if (!input.isSafe())
-    return m_stream->escape(input);
+    return s_filterStream->escape(input);
   return input;
 }
 
 bool Filter::isSafe() const { return false; }
+
+StreamingFilter::~StreamingFilter() = default;
+
+void StreamingFilter::writeResult(const Filter *filter, const QVariant &input,
+                                  const QVariant &argument,
+                                  OutputStream &stream, bool autoescape)
+{
+  const auto result = filter->doFilter(input, argument, autoescape);
+  if (!result.isValid())
+    return;
+
+  const auto resultString = getSafeString(result);
+  if (escapesResult(filter, input, resultString.isSafe(),
+                    resultString.needsEscape(), autoescape))
+    stream << stream.escape(resultString.get());
+  else
+    stream << resultString.get();
+}
+
+bool StreamingFilter::escapesResult(const Filter *filter,
+                                    const QVariant &input, bool resultIsSafe,
+                                    bool resultNeedsEscape, bool autoescape)
+{
+  // The safety rules of FilterExpression, followed by those of rendering.
+  auto inputIsSafe = false;
+  auto inputNeedsEscape = false;
+  if (input.userType() == qMetaTypeId<Grantlee::SafeString>()) {
+    const auto &inputString
+        = *static_cast<const Grantlee::SafeString *>(input.constData());
+    inputIsSafe = inputString.isSafe();
+    inputNeedsEscape = inputString.needsEscape();
+  }
+
+  if (filter->isSafe() && inputIsSafe)
+    resultIsSafe = true;
+  else if (inputNeedsEscape && !resultIsSafe)
+    resultNeedsEscape = true;
+
+  return resultNeedsEscape || (autoescape && !resultIsSafe);
+}
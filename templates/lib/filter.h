@@ -67,7 +67,8 @@ public:
 #ifndef Q_QDOC
   /**
     FilterExpression makes it possible to access stream methods like escape
-    while resolving.
+    while resolving. The stream is stored per thread, so that the same
+    **%Filter** can be used while rendering on several threads.
   */
   void setStream(OutputStream *stream);
 #endif
@@ -109,9 +110,109 @@ public:
 
 private:
 #ifndef Q_QDOC
+  // Unused since the stream became per thread. Kept so that the size of
+  // Filter does not change for filters built against older versions.
   OutputStream *m_stream;
 #endif
 };
+
+/// @headerfile filter.h grantlee/filter.h
+
+/**
+  @brief Interface for filters which can filter a string in place.
+
+  A Filter may also implement this interface. Consecutive filters which do
+  are run by the FilterExpression on a single string, without wrapping each
+  intermediate result in a QVariant.
+
+  This is separate from Filter, so that Filter does not change for plugins
+  built against older versions.
+
+  @code
+    class LowerFilter : public Grantlee::Filter, public Grantlee::InPlaceFilter
+    {
+      ...
+    };
+  @endcode
+*/
+class GRANTLEE_TEMPLATES_EXPORT InPlaceFilter
+{
+public:
+  /**
+    Destructor.
+  */
+  virtual ~InPlaceFilter();
+
+  /**
+    Reimplement to filter the string @p input in place given @p argument.
+
+    The content and safety of @p input must be left as the SafeString
+    returned by Filter::doFilter would be. A QString result corresponds to a
+    string which is not safe and does not need escaping. This is only called
+    when the input to the filter is a string.
+
+    @see @ref autoescaping
+  */
+  virtual void filterInPlace(SafeString &input, const QVariant &argument,
+                             bool autoescape) const = 0;
+};
+
+/// @headerfile filter.h grantlee/filter.h
+
+/**
+  @brief Interface for filters which can write their result to a stream.
+
+  A Filter may also implement this interface. When it is the last filter
+  applied to a variable which is rendered, its result is written directly to
+  the OutputStream instead of being returned.
+
+  As with InPlaceFilter, the FilterExpression looks this interface up with
+  dynamic_cast.
+*/
+class GRANTLEE_TEMPLATES_EXPORT StreamingFilter
+{
+public:
+  /**
+    Destructor.
+  */
+  virtual ~StreamingFilter();
+
+  /**
+    Reimplement to write the result of filtering @p input given @p argument to
+    @p stream.
+
+    The result must be written as the string returned by Filter::doFilter
+    would be rendered, escaping it if needed. Escaping needed to render the
+    result uses OutputStream::escape of @p stream, and @ref escapesResult may
+    be used to find out whether it is needed. Escaping done by the filter
+    itself must still use Filter::escape or Filter::conditionalEscape, as in
+    Filter::doFilter.
+
+    @see @ref autoescaping
+  */
+  virtual void doFilterToStream(const QVariant &input,
+                                const QVariant &argument,
+                                OutputStream &stream, bool autoescape) const
+      = 0;
+
+protected:
+  /**
+    Returns whether the result of filtering @p input with @p filter is escaped
+    when it is rendered, if the result is safe as given by @p resultIsSafe,
+    and needs escaping as given by @p resultNeedsEscape.
+  */
+  static bool escapesResult(const Filter *filter, const QVariant &input,
+                            bool resultIsSafe, bool resultNeedsEscape,
+                            bool autoescape);
+
+  /**
+    Writes the result of Filter::doFilter of @p filter to @p stream, as it
+    would be rendered.
+  */
+  static void writeResult(const Filter *filter, const QVariant &input,
+                          const QVariant &argument, OutputStream &stream,
+                          bool autoescape);
+};
 }
 
 #endif
@@ -21,6 +21,7 @@
 #include "filterexpression.h"
 
 #include <QtCore/QRegularExpression>
+#include <QtCore/QSharedData>
 
 #include "exception.h"
 #include "filter.h"
@@ -28,21 +29,50 @@
 #include "parser.h"
 #include "util.h"
 
+#include <new>
+#include <type_traits>
+
 using ArgFilter = QPair<QSharedPointer<Grantlee::Filter>, Grantlee::Variable>;
 
 namespace Grantlee
 {
 
-class FilterExpressionPrivate
+// A FilterExpressionPrivate is not changed once its FilterExpression is
+// constructed, so it is shared by all copies of the FilterExpression.
+class FilterExpressionPrivate : public QSharedData
 {
-  FilterExpressionPrivate(FilterExpression *fe) : q_ptr(fe) {}
+  // The new private is referenced by the FilterExpression creating it.
+  FilterExpressionPrivate() { ref.ref(); }
+
+  static FilterExpressionPrivate *sharedNull()
+  {
+    // Built in static storage and never destroyed, as its first reference
+    // is never released, so that moving a FilterExpression never allocates.
+    using Storage = std::aligned_storage<sizeof(FilterExpressionPrivate),
+                                         alignof(FilterExpressionPrivate)>::type;
+    static Storage storage;
+    static auto const null = new (&storage) FilterExpressionPrivate;
+    null->ref.ref();
+    return null;
+  }
+
+  QVariant resolveFilters(OutputStream *stream, Context *c,
+                          int filterCount) const;
+
+  void findInPlaceChains();
 
   Variable m_variable;
   QVector<ArgFilter> m_filters;
   QStringList m_filterNames;
-
-  Q_DECLARE_PUBLIC(FilterExpression)
-  FilterExpression *const q_ptr;
+  // For each filter, its InPlaceFilter interface if it has one, and the end
+  // of the chain of filters which can filter in place starting with it, or
+  // its own index if it can not.
+  QVector<const InPlaceFilter *> m_inPlaceFilters;
+  QVector<int> m_inPlaceChainEnds;
+  // The StreamingFilter interface of the last filter, if it has one.
+  const StreamingFilter *m_streamingFilter = nullptr;
+
+  friend class FilterExpression;
 };
 }
 
@@ -90,7 +120,7 @@ static QRegularExpression getFilterRegexp()
 }
 
 FilterExpression::FilterExpression(const QString &varString, Parser *parser)
-    : d_ptr(new FilterExpressionPrivate(this))
+    : d_ptr(new FilterExpressionPrivate)
 {
   Q_D(FilterExpression);
 
@@ -174,6 +204,7 @@ FilterExpression::FilterExpression(const QString &varString, Parser *parser)
                     pos,
                     varString);
     }
+    d->findInPlaceChains();
   } catch (...) {
     delete d_ptr;
     throw;
@@ -181,12 +212,19 @@ FilterExpression::FilterExpression(const QString &varString, Parser *parser)
 }
 
 FilterExpression::FilterExpression(const FilterExpression &other)
-    : d_ptr(new FilterExpressionPrivate(this))
+    : d_ptr(other.d_ptr)
+{
+  d_ptr->ref.ref();
+}
+
+FilterExpression::FilterExpression(FilterExpression &&other) noexcept
+    : d_ptr(FilterExpressionPrivate::sharedNull())
 {
-  *this = other;
+  qSwap(d_ptr, other.d_ptr);
 }
 
-FilterExpression::FilterExpression() : d_ptr(new FilterExpressionPrivate(this))
+FilterExpression::FilterExpression()
+    : d_ptr(FilterExpressionPrivate::sharedNull())
 {
 }
 
@@ -196,7 +234,11 @@ bool FilterExpression::isValid() const
   return d->m_variable.isValid();
 }
 
-FilterExpression::~FilterExpression() { delete d_ptr; }
+FilterExpression::~FilterExpression()
+{
+  if (!d_ptr->ref.deref())
+    delete d_ptr;
+}
 
 Variable FilterExpression::variable() const
 {
@@ -206,65 +248,171 @@ Variable FilterExpression::variable() const
 
 FilterExpression &FilterExpression::operator=(const FilterExpression &other)
 {
-  if (&other == this)
-    return *this;
-  d_ptr->m_variable = other.d_ptr->m_variable;
-  d_ptr->m_filters = other.d_ptr->m_filters;
-  d_ptr->m_filterNames = other.d_ptr->m_filterNames;
+  FilterExpression copy(other);
+  qSwap(d_ptr, copy.d_ptr);
   return *this;
 }
 
-QVariant FilterExpression::resolve(OutputStream *stream, Context *c) const
+FilterExpression &
+FilterExpression::operator=(FilterExpression &&other) noexcept
 {
-  Q_D(const FilterExpression);
-  auto var = d->m_variable.resolve(c);
+  qSwap(d_ptr, other.d_ptr);
+  return *this;
+}
 
-  auto it = d->m_filters.constBegin();
-  const auto end = d->m_filters.constEnd();
-  for (; it != end; ++it) {
-    auto filter = it->first;
-    filter->setStream(stream);
-    const auto argVar = it->second;
-    auto arg = argVar.resolve(c);
-
-    if (arg.isValid()) {
-      Grantlee::SafeString argString;
-      if (arg.userType() == qMetaTypeId<Grantlee::SafeString>()) {
-        argString = arg.value<Grantlee::SafeString>();
-      } else if (arg.userType() == qMetaTypeId<QString>()) {
-        argString = Grantlee::SafeString(arg.value<QString>());
-      }
-      if (argVar.isConstant()) {
-        argString = markSafe(argString);
-      }
-      if (!argString.get().isEmpty()) {
-        arg = argString;
+void FilterExpressionPrivate::findInPlaceChains()
+{
+  const auto count = m_filters.size();
+  m_inPlaceFilters.resize(count);
+  m_inPlaceChainEnds.resize(count);
+  auto chainEnd = count;
+  for (auto i = count - 1; i >= 0; --i) {
+    // Filters built against older versions do not know of the interface,
+    // so it is looked up instead of being asked for through Filter.
+    m_inPlaceFilters[i]
+        = dynamic_cast<const InPlaceFilter *>(m_filters.at(i).first.data());
+    if (!m_inPlaceFilters.at(i))
+      chainEnd = i;
+    m_inPlaceChainEnds[i] = chainEnd;
+  }
+  m_streamingFilter
+      = count > 0 ? dynamic_cast<const StreamingFilter *>(
+                        m_filters.last().first.data())
+                  : nullptr;
+}
+
+static QVariant resolveArgument(const Variable &argVar, Context *c)
+{
+  auto arg = argVar.resolve(c);
+
+  if (arg.userType() == qMetaTypeId<Grantlee::SafeString>()) {
+    // Only constants may need a new SafeString, and string literals are
+    // already marked safe when parsed.
+    if (argVar.isConstant()) {
+      const auto &argString
+          = *static_cast<const Grantlee::SafeString *>(arg.constData());
+      if (!argString.isSafe() && !argString.get().isEmpty())
+        arg = markSafe(argString);
+    }
+  } else if (arg.userType() == qMetaTypeId<QString>()) {
+    Grantlee::SafeString argString(arg.value<QString>());
+    if (argVar.isConstant()) {
+      argString = markSafe(argString);
+    }
+    if (!argString.get().isEmpty()) {
+      arg = argString;
+    }
+  }
+  return arg;
+}
+
+QVariant FilterExpressionPrivate::resolveFilters(OutputStream *stream,
+                                                 Context *c,
+                                                 int filterCount) const
+{
+  auto var = m_variable.resolve(c);
+
+  auto i = 0;
+  while (i < filterCount) {
+    const auto chainEnd = qMin(m_inPlaceChainEnds.at(i), filterCount);
+    if (chainEnd != i && isSafeString(var)) {
+      // The chain is run on one string, applying the same safety rules as
+      // below after each filter.
+      auto text = getSafeString(var);
+      for (; i < chainEnd; ++i) {
+        const auto &filter = m_filters.at(i).first;
+        filter->setStream(stream);
+        const auto arg = resolveArgument(m_filters.at(i).second, c);
+
+        const auto inputIsSafe = text.isSafe();
+        const auto inputNeedsEscape = text.needsEscape();
+        m_inPlaceFilters.at(i)->filterInPlace(text, arg, c->autoEscape());
+
+        if (filter->isSafe() && inputIsSafe) {
+          text.setSafety(Grantlee::SafeString::IsSafe);
+        } else if (inputNeedsEscape && !text.isSafe()) {
+          text.setNeedsEscape(true);
+        }
       }
+      var = QVariant::fromValue(text);
+      continue;
     }
 
-    const auto varString = getSafeString(var);
+    const auto &filter = m_filters.at(i).first;
+    filter->setStream(stream);
+    const auto arg = resolveArgument(m_filters.at(i).second, c);
+
+    // Only a SafeString input carries safety information into the result.
+    auto inputIsSafe = false;
+    auto inputNeedsEscape = false;
+    if (var.userType() == qMetaTypeId<Grantlee::SafeString>()) {
+      const auto &varString
+          = *static_cast<const Grantlee::SafeString *>(var.constData());
+      inputIsSafe = varString.isSafe();
+      inputNeedsEscape = varString.needsEscape();
+    }
 
     var = filter->doFilter(var, arg, c->autoEscape());
 
-    if (var.userType() == qMetaTypeId<Grantlee::SafeString>()
-        || var.userType() == qMetaTypeId<QString>()) {
-      if (filter->isSafe() && varString.isSafe()) {
-        var = markSafe(getSafeString(var));
-      } else if (varString.needsEscape()) {
-        var = markForEscaping(getSafeString(var));
+    if (var.userType() == qMetaTypeId<Grantlee::SafeString>()) {
+      const auto &result
+          = *static_cast<const Grantlee::SafeString *>(var.constData());
+      if (filter->isSafe() && inputIsSafe) {
+        if (!result.isSafe())
+          var = markSafe(result);
+      } else if (inputNeedsEscape) {
+        if (!result.isSafe() && !result.needsEscape())
+          var = markForEscaping(result);
+      }
+    } else if (var.userType() == qMetaTypeId<QString>()) {
+      const Grantlee::SafeString result(var.value<QString>());
+      if (filter->isSafe() && inputIsSafe) {
+        var = markSafe(result);
+      } else if (inputNeedsEscape) {
+        var = markForEscaping(result);
       } else {
-        var = getSafeString(var);
+        var = result;
       }
     }
+    ++i;
   }
+  return var;
+}
+
+QVariant FilterExpression::resolve(OutputStream *stream, Context *c) const
+{
+  Q_D(const FilterExpression);
+  const auto var = d->resolveFilters(stream, c, d->m_filters.size());
   (*stream) << getSafeString(var).get();
   return var;
 }
 
 QVariant FilterExpression::resolve(Context *c) const
 {
+  Q_D(const FilterExpression);
+  // Filters may still use the stream to escape, but nothing is written.
+  OutputStream _dummy;
+  return d->resolveFilters(&_dummy, c, d->m_filters.size());
+}
+
+QVariant FilterExpression::resolveForOutput(OutputStream *stream,
+                                            Context *c) const
+{
+  Q_D(const FilterExpression);
+  if (!d->m_streamingFilter)
+    return resolve(c);
+
+  // The filters escape with the same stream as when resolving without
+  // output, so that the result does not depend on which way is used.
+  // Only the escaping needed to render the result uses @p stream.
   OutputStream _dummy;
-  return resolve(&_dummy, c);
+  const auto last = d->m_filters.size() - 1;
+  const auto var = d->resolveFilters(&_dummy, c, last);
+  const auto &argFilter = d->m_filters.at(last);
+  argFilter.first->setStream(&_dummy);
+  d->m_streamingFilter->doFilterToStream(
+      var, resolveArgument(argFilter.second, c), *stream, c->autoEscape());
+  return {};
 }
 
 QVariantList FilterExpression::toList(Context *c) const
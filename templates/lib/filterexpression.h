@@ -135,6 +135,11 @@ public:
   */
   FilterExpression(const FilterExpression &other);
 
+  /**
+    Move constructor.
+  */
+  FilterExpression(FilterExpression &&other) noexcept;
+
   /**
     Destructor.
   */
@@ -145,6 +150,11 @@ public:
   */
   FilterExpression &operator=(const FilterExpression &other);
 
+  /**
+    Move assignment operator.
+  */
+  FilterExpression &operator=(FilterExpression &&other) noexcept;
+
   /**
     Returns the initial variable in the **%FilterExpression**.
   */
@@ -161,6 +171,17 @@ public:
   */
   QVariant resolve(Context *c) const;
 
+  /**
+    Resolves the **%FilterExpression** in the Context @p c for rendering to
+    @p stream.
+
+    If the last filter can write its result to a stream, the result is
+    written to @p stream, escaped as needed, and an invalid QVariant is
+    returned. Otherwise nothing is written and the resolved value is
+    returned.
+  */
+  QVariant resolveForOutput(OutputStream *stream, Context *c) const;
+
   /**
     Returns whether the Filter resolves to true in the Context @p c.
     @see @ref truthiness
@@ -193,7 +214,7 @@ public:
 
 private:
   Q_DECLARE_PRIVATE(FilterExpression)
-  FilterExpressionPrivate *const d_ptr;
+  FilterExpressionPrivate *d_ptr;
 };
 }
 
@@ -0,0 +1,62 @@
+/*
+  This file is part of the Grantlee template system.
+
+  Copyright (c) 2026 agent <agent@local>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either version
+  2.1 of the Licence, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef GRANTLEE_FORWARDITERABLE_P_H
+#define GRANTLEE_FORWARDITERABLE_P_H
+
+#include <QtCore/QSharedPointer>
+#include <QtCore/QVariant>
+
+#include <functional>
+
+namespace Grantlee
+{
+
+/**
+  @internal The value stored in the Context by Context::forwardIterable.
+
+  Each iteration calls @ref begin for a new function producing the items, so
+  the items are never held all at once unless the value is converted to a
+  list.
+*/
+struct ForwardIterable {
+  using NextFunction = std::function<bool(QVariant &)>;
+  using BeginFunction = std::function<NextFunction()>;
+
+  QVariantList toList() const
+  {
+    QVariantList list;
+    if (size > 0)
+      list.reserve(size);
+    const auto next = (*begin)();
+    QVariant item;
+    while (next(item))
+      list.append(item);
+    return list;
+  }
+
+  QSharedPointer<const BeginFunction> begin;
+  int size = -1;
+};
+}
+
+Q_DECLARE_METATYPE(Grantlee::ForwardIterable)
+
+#endif
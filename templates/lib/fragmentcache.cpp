@@ -0,0 +1,295 @@
+/*
+  This file is part of the Grantlee template system.
+
+  Copyright (c) 2026 agent <agent@local>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either version
+  2.1 of the Licence, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "fragmentcache.h"
+
+#include <QtCore/QCache>
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDataStream>
+#include <QtCore/QDateTime>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QMutex>
+#include <QtCore/QSaveFile>
+
+#include <atomic>
+
+namespace Grantlee
+{
+
+class AbstractFragmentCachePrivate
+{
+  AbstractFragmentCachePrivate(AbstractFragmentCache *qq)
+      : q_ptr(qq), m_hits(0), m_misses(0)
+  {
+  }
+
+  Q_DECLARE_PUBLIC(AbstractFragmentCache)
+  AbstractFragmentCache *const q_ptr;
+
+  std::atomic<quint64> m_hits;
+  std::atomic<quint64> m_misses;
+};
+
+/**
+  A cached fragment, and the time in milliseconds since the epoch at which it
+  expires, or 0 if it does not expire.
+*/
+struct CachedFragment {
+  QString fragment;
+  qint64 expiry;
+};
+
+static qint64 expiryTime(int timeout)
+{
+  if (timeout < 0)
+    return 0;
+  return QDateTime::currentMSecsSinceEpoch() + qint64(timeout) * 1000;
+}
+
+static bool isExpired(qint64 expiry)
+{
+  return expiry != 0 && expiry <= QDateTime::currentMSecsSinceEpoch();
+}
+
+struct FragmentCacheShard {
+  QMutex mutex;
+  // QCache discards the least recently used fragments first.
+  QCache<QString, CachedFragment> fragments;
+};
+
+class InMemoryFragmentCachePrivate
+{
+  InMemoryFragmentCachePrivate(InMemoryFragmentCache *qq, int maxSize,
+                               int shardCount)
+      : q_ptr(qq), m_shardCount(qMax(1, shardCount)),
+        m_shards(new FragmentCacheShard[m_shardCount])
+  {
+    const auto maxShardSize = qMax(1, maxSize / m_shardCount);
+    for (auto i = 0; i < m_shardCount; ++i)
+      m_shards[i].fragments.setMaxCost(maxShardSize);
+  }
+
+  ~InMemoryFragmentCachePrivate() { delete[] m_shards; }
+
+  FragmentCacheShard &shard(const QString &key) const
+  {
+    return m_shards[qHash(key) % uint(m_shardCount)];
+  }
+
+  Q_DECLARE_PUBLIC(InMemoryFragmentCache)
+  InMemoryFragmentCache *const q_ptr;
+
+  const int m_shardCount;
+  FragmentCacheShard *const m_shards;
+};
+
+class FileSystemFragmentCachePrivate
+{
+  FileSystemFragmentCachePrivate(FileSystemFragmentCache *qq,
+                                 const QString &directory)
+      : q_ptr(qq), m_directory(directory)
+  {
+  }
+
+  QString fileName(const QString &key) const
+  {
+    return m_directory + QLatin1Char('/')
+           + QString::fromLatin1(
+                 QCryptographicHash::hash(key.toUtf8(),
+                                          QCryptographicHash::Sha1)
+                     .toHex())
+           + QStringLiteral(".fragment");
+  }
+
+  Q_DECLARE_PUBLIC(FileSystemFragmentCache)
+  FileSystemFragmentCache *const q_ptr;
+
+  const QString m_directory;
+};
+}
+
+using namespace Grantlee;
+
+AbstractFragmentCache::AbstractFragmentCache()
+    : d_ptr(new AbstractFragmentCachePrivate(this))
+{
+}
+
+AbstractFragmentCache::~AbstractFragmentCache() { delete d_ptr; }
+
+bool AbstractFragmentCache::lookup(const QString &key, QString *fragment)
+{
+  Q_D(AbstractFragmentCache);
+  if (doLookup(key, fragment)) {
+    ++d->m_hits;
+    return true;
+  }
+  ++d->m_misses;
+  return false;
+}
+
+void AbstractFragmentCache::insert(const QString &key,
+                                   const QString &fragment, int timeout)
+{
+  if (timeout == 0)
+    return;
+  doInsert(key, fragment, timeout);
+}
+
+quint64 AbstractFragmentCache::hits() const
+{
+  Q_D(const AbstractFragmentCache);
+  return d->m_hits;
+}
+
+quint64 AbstractFragmentCache::misses() const
+{
+  Q_D(const AbstractFragmentCache);
+  return d->m_misses;
+}
+
+void AbstractFragmentCache::resetStatistics()
+{
+  Q_D(AbstractFragmentCache);
+  d->m_hits = 0;
+  d->m_misses = 0;
+}
+
+InMemoryFragmentCache::InMemoryFragmentCache(int maxSize, int shardCount)
+    : d_ptr(new InMemoryFragmentCachePrivate(this, maxSize, shardCount))
+{
+}
+
+InMemoryFragmentCache::~InMemoryFragmentCache() { delete d_ptr; }
+
+void InMemoryFragmentCache::clear()
+{
+  Q_D(InMemoryFragmentCache);
+  for (auto i = 0; i < d->m_shardCount; ++i) {
+    auto &shard = d->m_shards[i];
+    QMutexLocker locker(&shard.mutex);
+    shard.fragments.clear();
+  }
+}
+
+int InMemoryFragmentCache::size() const
+{
+  Q_D(const InMemoryFragmentCache);
+  auto size = 0;
+  for (auto i = 0; i < d->m_shardCount; ++i) {
+    auto &shard = d->m_shards[i];
+    QMutexLocker locker(&shard.mutex);
+    size += shard.fragments.size();
+  }
+  return size;
+}
+
+bool InMemoryFragmentCache::doLookup(const QString &key, QString *fragment)
+{
+  Q_D(InMemoryFragmentCache);
+  auto &shard = d->shard(key);
+  QMutexLocker locker(&shard.mutex);
+
+  const auto cached = shard.fragments.object(key);
+  if (!cached)
+    return false;
+
+  if (isExpired(cached->expiry)) {
+    shard.fragments.remove(key);
+    return false;
+  }
+  *fragment = cached->fragment;
+  return true;
+}
+
+void InMemoryFragmentCache::doInsert(const QString &key,
+                                     const QString &fragment, int timeout)
+{
+  Q_D(InMemoryFragmentCache);
+  auto &shard = d->shard(key);
+  QMutexLocker locker(&shard.mutex);
+
+  // Fragments larger than the shard are not cached at all.
+  shard.fragments.insert(key, new CachedFragment{fragment, expiryTime(timeout)},
+                         qMax(1, int(fragment.size())));
+}
+
+FileSystemFragmentCache::FileSystemFragmentCache(const QString &directory)
+    : d_ptr(new FileSystemFragmentCachePrivate(this, directory))
+{
+  QDir().mkpath(directory);
+}
+
+FileSystemFragmentCache::~FileSystemFragmentCache() { delete d_ptr; }
+
+QString FileSystemFragmentCache::directory() const
+{
+  Q_D(const FileSystemFragmentCache);
+  return d->m_directory;
+}
+
+void FileSystemFragmentCache::clear()
+{
+  Q_D(FileSystemFragmentCache);
+  QDir dir(d->m_directory);
+  const auto files
+      = dir.entryList({QStringLiteral("*.fragment")}, QDir::Files);
+  for (const auto &file : files)
+    dir.remove(file);
+}
+
+bool FileSystemFragmentCache::doLookup(const QString &key, QString *fragment)
+{
+  Q_D(FileSystemFragmentCache);
+  QFile file(d->fileName(key));
+  if (!file.open(QIODevice::ReadOnly))
+    return false;
+
+  QDataStream in(&file);
+  QString storedKey;
+  qint64 expiry;
+  QString storedFragment;
+  in >> storedKey >> expiry >> storedFragment;
+  if (in.status() != QDataStream::Ok || storedKey != key)
+    return false;
+
+  if (isExpired(expiry)) {
+    file.remove();
+    return false;
+  }
+  *fragment = storedFragment;
+  return true;
+}
+
+void FileSystemFragmentCache::doInsert(const QString &key,
+                                       const QString &fragment, int timeout)
+{
+  Q_D(FileSystemFragmentCache);
+  // Write to a temporary file first, so that concurrent lookups never see a
+  // partially written fragment.
+  QSaveFile file(d->fileName(key));
+  if (!file.open(QIODevice::WriteOnly))
+    return;
+
+  QDataStream out(&file);
+  out << key << expiryTime(timeout) << fragment;
+  file.commit();
+}
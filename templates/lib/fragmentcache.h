@@ -0,0 +1,235 @@
+/*
+  This file is part of the Grantlee template system.
+
+  Copyright (c) 2026 agent <agent@local>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either version
+  2.1 of the Licence, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef GRANTLEE_FRAGMENTCACHE_H
+#define GRANTLEE_FRAGMENTCACHE_H
+
+#include "grantlee_templates_export.h"
+
+#include <QtCore/QString>
+
+namespace Grantlee
+{
+
+class AbstractFragmentCachePrivate;
+
+/// @headerfile fragmentcache.h grantlee/fragmentcache.h
+
+/**
+  @brief A storage location for fragments rendered by the @gr_tag{cache} tag.
+
+  This interface can be implemented to define new places to keep rendered
+  fragments of Templates.
+
+  Implementations must be safe to use from several threads at once, as
+  Templates may be rendered concurrently.
+
+  A fragment cache is typically created and set on the Grantlee::Engine, which
+  makes it available to the @gr_tag{cache} tag.
+
+  @code
+    engine->setFragmentCache(
+        QSharedPointer<Grantlee::InMemoryFragmentCache>::create() );
+  @endcode
+
+  The number of hits and misses is counted by the **%AbstractFragmentCache**
+  and can be read with @ref hits and @ref misses.
+
+  @author agent <agent@local>
+*/
+class GRANTLEE_TEMPLATES_EXPORT AbstractFragmentCache
+{
+public:
+  /**
+    Constructor
+  */
+  AbstractFragmentCache();
+
+  /**
+    Destructor
+  */
+  virtual ~AbstractFragmentCache();
+
+  /**
+    Returns whether a fragment identified by @p key is cached, and if so
+    stores it in @p fragment.
+  */
+  bool lookup(const QString &key, QString *fragment);
+
+  /**
+    Stores @p fragment identified by @p key for @p timeout seconds.
+
+    As in Django, a @p timeout of 0 means that the fragment is not stored.
+    Django uses None for fragments which never expire, which templates can
+    not express, so a negative @p timeout is used for them instead.
+  */
+  void insert(const QString &key, const QString &fragment, int timeout);
+
+  /**
+    Removes all fragments from the cache.
+  */
+  virtual void clear() = 0;
+
+  /**
+    Returns the number of lookups which found a fragment.
+  */
+  quint64 hits() const;
+
+  /**
+    Returns the number of lookups which did not find a fragment.
+  */
+  quint64 misses() const;
+
+  /**
+    Resets the @ref hits and @ref misses counts.
+  */
+  void resetStatistics();
+
+protected:
+  /**
+    Reimplement to find the fragment identified by @p key.
+  */
+  virtual bool doLookup(const QString &key, QString *fragment) = 0;
+
+  /**
+    Reimplement to store @p fragment identified by @p key for @p timeout
+    seconds, or without expiry if @p timeout is negative. This is not called
+    with a @p timeout of 0.
+  */
+  virtual void doInsert(const QString &key, const QString &fragment,
+                        int timeout)
+      = 0;
+
+private:
+  Q_DISABLE_COPY(AbstractFragmentCache)
+  Q_DECLARE_PRIVATE(AbstractFragmentCache)
+  AbstractFragmentCachePrivate *const d_ptr;
+};
+
+class InMemoryFragmentCachePrivate;
+
+/// @headerfile fragmentcache.h grantlee/fragmentcache.h
+
+/**
+  @brief The **%InMemoryFragmentCache** keeps rendered fragments in memory.
+
+  Fragments are spread over a number of shards, each with its own lock, so
+  that concurrent renders rarely wait for each other. When a shard holds more
+  than its share of @p maxSize characters, the least recently used fragments
+  in it are discarded.
+
+  @code
+    // Keep at most 64 million characters, in 32 shards.
+    auto cache = QSharedPointer<Grantlee::InMemoryFragmentCache>::create(
+        64 * 1024 * 1024, 32 );
+    engine->setFragmentCache( cache );
+  @endcode
+
+  @author agent <agent@local>
+*/
+class GRANTLEE_TEMPLATES_EXPORT InMemoryFragmentCache
+    : public AbstractFragmentCache
+{
+public:
+  /**
+    Constructs a cache holding about @p maxSize characters of fragments in
+    @p shardCount shards.
+  */
+  explicit InMemoryFragmentCache(int maxSize = 16 * 1024 * 1024,
+                                 int shardCount = 16);
+
+  /**
+    Destructor
+  */
+  ~InMemoryFragmentCache() override;
+
+  void clear() override;
+
+  /**
+    Returns the number of fragments in the cache.
+  */
+  int size() const;
+
+protected:
+  bool doLookup(const QString &key, QString *fragment) override;
+
+  void doInsert(const QString &key, const QString &fragment,
+                int timeout) override;
+
+private:
+  Q_DECLARE_PRIVATE(InMemoryFragmentCache)
+  InMemoryFragmentCachePrivate *const d_ptr;
+};
+
+class FileSystemFragmentCachePrivate;
+
+/// @headerfile fragmentcache.h grantlee/fragmentcache.h
+
+/**
+  @brief The **%FileSystemFragmentCache** keeps rendered fragments in files.
+
+  Each fragment is stored in one file in a local directory, so the cache
+  survives the application and may be shared by several processes on the
+  same machine.
+
+  @code
+    auto cache = QSharedPointer<Grantlee::FileSystemFragmentCache>::create(
+        QStandardPaths::writableLocation( QStandardPaths::CacheLocation )
+        + "/fragments" );
+    engine->setFragmentCache( cache );
+  @endcode
+
+  @author agent <agent@local>
+*/
+class GRANTLEE_TEMPLATES_EXPORT FileSystemFragmentCache
+    : public AbstractFragmentCache
+{
+public:
+  /**
+    Constructs a cache storing fragments in @p directory. The directory is
+    created if it does not exist.
+  */
+  explicit FileSystemFragmentCache(const QString &directory);
+
+  /**
+    Destructor
+  */
+  ~FileSystemFragmentCache() override;
+
+  /**
+    Returns the directory the fragments are stored in.
+  */
+  QString directory() const;
+
+  void clear() override;
+
+protected:
+  bool doLookup(const QString &key, QString *fragment) override;
+
+  void doInsert(const QString &key, const QString &fragment,
+                int timeout) override;
+
+private:
+  Q_DECLARE_PRIVATE(FileSystemFragmentCache)
+  FileSystemFragmentCachePrivate *const d_ptr;
+};
+}
+
+#endif
@@ -6,4 +6,15 @@
  */
 #define GRANTLEE_PLUGIN_PATH "@Grantlee_PLUGIN_INSTALL_DIR@"
 
+/**
+ * Whether the defaulttags, loadertags and defaultfilters plugins are compiled
+ * into the Grantlee_Templates library
+ */
+#cmakedefine GRANTLEE_STATIC_MAIN_PLUGINS
+
+/**
+ * Whether the i18ntags plugin is compiled into the Grantlee_Templates library
+ */
+#cmakedefine GRANTLEE_STATIC_I18N_PLUGIN
+
 #endif // GRANTLEE_CONFIG_H
@@ -28,6 +28,7 @@
 #include "grantlee/exception.h"
 #include "grantlee/filter.h"
 #include "grantlee/filterexpression.h"
+#include "grantlee/fragmentcache.h"
 #include "grantlee/grantlee_version.h"
 #include "grantlee/metatype.h"
 #include "grantlee/node.h"
@@ -23,15 +23,66 @@
 
 #include "customtyperegistry_p.h"
 #include "metaenumvariable_p.h"
+#include "modelrows_p.h"
 
 #include <QtCore/QAssociativeIterable>
 #include <QtCore/QDebug>
 #include <QtCore/QSequentialIterable>
 
+#include <atomic>
+
 using namespace Grantlee;
 
 Q_GLOBAL_STATIC(CustomTypeRegistry, customTypes)
 
+namespace
+{
+enum LookupStrategy : quint8 {
+  UnknownStrategy,
+  QObjectStrategy,
+  SequentialStrategy,
+  AssociativeStrategy,
+  GadgetStrategy,
+  CustomStrategy
+};
+}
+
+static LookupStrategy findLookupStrategy(const QVariant &object)
+{
+  if (object.canConvert<QObject *>())
+    return QObjectStrategy;
+  if (object.canConvert<QVariantList>())
+    return SequentialStrategy;
+  if (object.canConvert<QVariantHash>())
+    return AssociativeStrategy;
+  const QMetaType mt(object.userType());
+  if (mt.metaObject() && mt.flags().testFlag(QMetaType::IsGadget))
+    return GadgetStrategy;
+  return CustomStrategy;
+}
+
+// The strategies found for the built-in types and the first user types, so
+// that each canConvert probe is made once per type rather than once per
+// lookup. Threads finding the strategy of a type at the same time store the
+// same value.
+static const int cachedStrategyCount = QMetaType::HighestInternalId + 1 + 4096;
+static std::atomic<quint8> cachedStrategies[cachedStrategyCount];
+
+static LookupStrategy lookupStrategy(const QVariant &object)
+{
+  const auto slot = CustomTypeRegistry::typeSlot(object.userType());
+  if (slot < 0 || slot >= cachedStrategyCount)
+    return findLookupStrategy(object);
+
+  auto strategy = LookupStrategy(
+      cachedStrategies[slot].load(std::memory_order_relaxed));
+  if (strategy == UnknownStrategy) {
+    strategy = findLookupStrategy(object);
+    cachedStrategies[slot].store(strategy, std::memory_order_relaxed);
+  }
+  return strategy;
+}
+
 void Grantlee::MetaType::internalLock() { return customTypes()->mutex.lock(); }
 
 void Grantlee::MetaType::internalUnlock()
@@ -111,10 +162,20 @@ static QVariant doQobjectLookUp(const QObject *const object,
 QVariant Grantlee::MetaType::lookup(const QVariant &object,
                                     const QString &property)
 {
-  if (object.canConvert<QObject *>()) {
-    return doQobjectLookUp(object.value<QObject *>(), property);
+  switch (lookupStrategy(object)) {
+  case QObjectStrategy: {
+    const auto qobject = object.value<QObject *>();
+    auto result = doQobjectLookUp(qobject, property);
+    // The rows of a model are looked up like a list, unless the model has a
+    // property of the same name.
+    if (!result.isValid()) {
+      const ModelRows rows(qobject_cast<QAbstractItemModel *>(qobject));
+      if (rows.isValid())
+        return customTypes()->lookup(QVariant::fromValue(rows), property);
+    }
+    return result;
   }
-  if (object.canConvert<QVariantList>()) {
+  case SequentialStrategy: {
     auto iter = object.value<QSequentialIterable>();
     if (property == QStringLiteral("size")
         || property == QStringLiteral("count")) {
@@ -130,8 +191,7 @@ QVariant Grantlee::MetaType::lookup(const QVariant &object,
 
     return iter.at(listIndex);
   }
-  if (object.canConvert<QVariantHash>()) {
-
+  case AssociativeStrategy: {
     auto iter = object.value<QAssociativeIterable>();
 
     if (iter.find(property) != iter.end()) {
@@ -175,43 +235,46 @@ QVariant Grantlee::MetaType::lookup(const QVariant &object,
 
     return {};
   }
-  auto mo = QMetaType(object.userType()).metaObject();
-  if (mo) {
-    QMetaType mt(object.userType());
-    if (mt.flags().testFlag(QMetaType::IsGadget)) {
-      const auto idx = mo->indexOfProperty(property.toUtf8().constData());
-      if (idx >= 0) {
-        const auto mp = mo->property(idx);
-
-        if (mp.isEnumType()) {
-          MetaEnumVariable mev(
-              mp.enumerator(),
-              mp.readOnGadget(object.constData()).value<int>());
-          return QVariant::fromValue(mev);
-        }
-
-        return mp.readOnGadget(object.constData());
+  case GadgetStrategy: {
+    const auto mo = QMetaType(object.userType()).metaObject();
+    const auto idx = mo->indexOfProperty(property.toUtf8().constData());
+    if (idx >= 0) {
+      const auto mp = mo->property(idx);
+
+      if (mp.isEnumType()) {
+        MetaEnumVariable mev(
+            mp.enumerator(),
+            mp.readOnGadget(object.constData()).value<int>());
+        return QVariant::fromValue(mev);
       }
 
-      QMetaEnum me;
-      for (auto i = 0; i < mo->enumeratorCount(); ++i) {
-        me = mo->enumerator(i);
+      return mp.readOnGadget(object.constData());
+    }
 
-        if (QLatin1String(me.name()) == property) {
-          MetaEnumVariable mev(me);
-          return QVariant::fromValue(mev);
-        }
+    QMetaEnum me;
+    for (auto i = 0; i < mo->enumeratorCount(); ++i) {
+      me = mo->enumerator(i);
 
-        const auto value = me.keyToValue(property.toLatin1().constData());
+      if (QLatin1String(me.name()) == property) {
+        MetaEnumVariable mev(me);
+        return QVariant::fromValue(mev);
+      }
 
-        if (value < 0) {
-          continue;
-        }
+      const auto value = me.keyToValue(property.toLatin1().constData());
 
-        MetaEnumVariable mev(me, value);
-        return QVariant::fromValue(mev);
+      if (value < 0) {
+        continue;
       }
+
+      MetaEnumVariable mev(me, value);
+      return QVariant::fromValue(mev);
     }
+
+    // Gadgets may also have a registered lookup function.
+    break;
+  }
+  default:
+    break;
   }
 
   return customTypes()->lookup(object, property);
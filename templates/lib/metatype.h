@@ -26,7 +26,11 @@
 
 #include "typeaccessor.h"
 
+#include <QtCore/QPair>
 #include <QtCore/QVariant>
+#include <QtCore/QVector>
+
+#include <initializer_list>
 
 /// @file
 
@@ -190,6 +194,66 @@ template <typename RealType, typename HandleAs> int registerMetaType()
   return id;
 }
 
+/// @headerfile metatype.h grantlee/metatype.h
+
+/**
+  @brief A table of the properties of a type, to look them up by name.
+
+  The properties are grouped by the length of their names, so that a lookup
+  only compares the names of the same length as the requested one, rather
+  than every name in turn.
+
+  It is usually created with the @ref GRANTLEE_BEGIN_LOOKUP_TABLE and
+  @ref GRANTLEE_END_LOOKUP_TABLE macros.
+*/
+template <typename Type> class LookupTable
+{
+public:
+  /**
+    The signature of a function returning a property of @p object.
+  */
+  typedef QVariant (*Accessor)(const Type &object);
+
+  /**
+    A property named @p name, read by @p accessor.
+  */
+  struct Property {
+    const char *name;
+    Accessor accessor;
+  };
+
+  /**
+    Constructs a table of @p properties.
+  */
+  LookupTable(std::initializer_list<Property> properties)
+  {
+    for (const auto &property : properties) {
+      const auto name = QString::fromLatin1(property.name);
+      if (name.size() >= m_properties.size())
+        m_properties.resize(name.size() + 1);
+      m_properties[name.size()].append(qMakePair(name, property.accessor));
+    }
+  }
+
+  /**
+    Returns the property of @p object named @p property, or an invalid
+    QVariant if there is no such property.
+  */
+  QVariant lookUp(const Type &object, const QString &property) const
+  {
+    if (property.size() >= m_properties.size())
+      return {};
+    for (const auto &entry : m_properties.at(property.size())) {
+      if (entry.first == property)
+        return entry.second(object);
+    }
+    return {};
+  }
+
+private:
+  QVector<QVector<QPair<QString, Accessor>>> m_properties;
+};
+
 #ifndef Q_QDOC
 /**
   @internal
@@ -241,4 +305,43 @@ template <typename Type> int registerMetaType()
   }                                                                            \
   }
 
+/**
+  Top boundary of a lookup table for Type.
+
+  Between this and @ref GRANTLEE_END_LOOKUP_TABLE is a list of property names
+  and functions returning the property from the <tt>object</tt>. Unlike a
+  lookup function written with @ref GRANTLEE_BEGIN_LOOKUP, the table does not
+  compare the name of each property in turn, which makes lookups of types
+  with many properties faster.
+
+  @code
+    GRANTLEE_BEGIN_LOOKUP_TABLE(Person)
+      { "name", [](const Person &person) -> QVariant { return person.name(); } },
+      { "age", [](const Person &person) -> QVariant { return person.age(); } },
+    GRANTLEE_END_LOOKUP_TABLE
+  @endcode
+
+  @see @ref generic_types
+ */
+#define GRANTLEE_BEGIN_LOOKUP_TABLE(Type)                                      \
+  namespace Grantlee                                                           \
+  {                                                                            \
+  template <>                                                                  \
+  inline QVariant TypeAccessor<Type &>::lookUp(const Type &object,             \
+                                               const QString &property)        \
+  {                                                                            \
+    static const LookupTable<Type> table{
+
+/**
+  Bottom boundary of a lookup table for Type.
+
+  @see @ref generic_types
+ */
+#define GRANTLEE_END_LOOKUP_TABLE                                              \
+  }                                                                            \
+  ;                                                                            \
+  return table.lookUp(object, property);                                       \
+  }                                                                            \
+  }
+
 #endif // #define GRANTLEE_METATYPE_H
@@ -0,0 +1,112 @@
+/*
+  This file is part of the Grantlee template system.
+
+  Copyright (c) 2026 agent <agent@local>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either version
+  2.1 of the Licence, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef GRANTLEE_MODELROWS_P_H
+#define GRANTLEE_MODELROWS_P_H
+
+#include <QtCore/QAbstractItemModel>
+#include <QtCore/QVariant>
+
+/**
+  The rows below a parent index of a QAbstractItemModel, which templates
+  iterate and index like a list. Each row is the QModelIndex of its first
+  column, so the data of a row is only read when a role of it is looked up.
+
+  Models which populate themselves incrementally are only asked to fetch
+  more rows when a row beyond those already fetched is needed.
+*/
+struct ModelRows {
+  ModelRows() : model(nullptr) {}
+
+  explicit ModelRows(QAbstractItemModel *_model,
+                     const QModelIndex &_parent = QModelIndex())
+      : model(_model), parent(_parent)
+  {
+  }
+
+  /**
+    Returns the rows held by @p variant, which are all rows of the model if
+    it holds a QAbstractItemModel.
+  */
+  static ModelRows fromVariant(const QVariant &variant)
+  {
+    if (variant.userType() == qMetaTypeId<ModelRows>())
+      return variant.value<ModelRows>();
+    if (variant.canConvert<QObject *>())
+      return ModelRows(
+          qobject_cast<QAbstractItemModel *>(variant.value<QObject *>()));
+    return {};
+  }
+
+  bool isValid() const { return model != nullptr; }
+
+  /**
+    Returns whether @p row exists, fetching more rows until it does or the
+    model can not fetch any more.
+  */
+  bool hasRow(int row) const
+  {
+    if (row < 0)
+      return false;
+    auto rowCount = model->rowCount(parent);
+    while (row >= rowCount) {
+      if (!fetchMore(rowCount))
+        return false;
+    }
+    return true;
+  }
+
+  /**
+    Returns the number of rows, after fetching all of them.
+  */
+  int size() const
+  {
+    auto rowCount = model->rowCount(parent);
+    while (fetchMore(rowCount)) {
+    }
+    return rowCount;
+  }
+
+  QVariant at(int row) const
+  {
+    if (!hasRow(row))
+      return {};
+    return QVariant::fromValue(model->index(row, 0, parent));
+  }
+
+  QAbstractItemModel *model;
+  QModelIndex parent;
+
+private:
+  bool fetchMore(int &rowCount) const
+  {
+    if (!model->canFetchMore(parent))
+      return false;
+    model->fetchMore(parent);
+    const auto previousRowCount = rowCount;
+    rowCount = model->rowCount(parent);
+    // Do not wait forever for a model which never fetches anything.
+    return rowCount > previousRowCount;
+  }
+};
+
+Q_DECLARE_METATYPE(ModelRows)
+
+#endif
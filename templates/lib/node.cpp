@@ -21,6 +21,7 @@
 #include "node.h"
 
 #include "metaenumvariable_p.h"
+#include "nodearena_p.h"
 #include "nodebuiltins_p.h"
 #include "template.h"
 #include "util.h"
@@ -34,10 +35,25 @@ namespace Grantlee
 
 class NodePrivate
 {
-  NodePrivate(Node *node, const Grantlee::Token token) : q_ptr(node), m_token(token) {}
+  NodePrivate(Node *node, const Grantlee::Token token)
+      : q_ptr(node), m_token(token),
+        m_template(NodeArena::current()
+                       ? NodeArena::current()->containerTemplate()
+                       : nullptr)
+  {
+  }
+
+  static void *operator new(std::size_t size)
+  {
+    return NodeArena::allocate(size);
+  }
+
+  static void operator delete(void *ptr) { NodeArena::deallocate(ptr); }
+
   Q_DECLARE_PUBLIC(Node)
   Node *const q_ptr;
   Grantlee::Token const m_token;
+  TemplateImpl *const m_template;
 };
 
 class AbstractNodeFactoryPrivate
@@ -86,6 +102,10 @@ Node::Node(const Grantlee::Token& token, QObject *parent) : QObject(parent), d_p
 
 Node::~Node() { delete d_ptr; }
 
+void *Node::operator new(std::size_t size) { return NodeArena::allocate(size); }
+
+void Node::operator delete(void *ptr) { NodeArena::deallocate(ptr); }
+
 const Grantlee::Token& Node::token() const
 {
     return d_ptr->m_token;
@@ -112,6 +132,11 @@ void Node::streamValueInContext(OutputStream *stream, const QVariant &input,
 
 TemplateImpl *Node::containerTemplate() const
 {
+  if (d_ptr->m_template)
+    return d_ptr->m_template;
+
+  // Nodes created outside of compiling a Template are only related to it
+  // through the QObject tree.
   auto _parent = parent();
   auto ti = qobject_cast<TemplateImpl *>(_parent);
   while (_parent && !ti) {
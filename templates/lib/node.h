@@ -113,6 +113,38 @@ public:
   { // krazy:exclude:inline
     return false;
   }
+
+  /**
+    @internal
+
+    Nodes created while a Template is being compiled are allocated from
+    storage owned by that Template. The QObject data of each node is still
+    allocated by QObject.
+  */
+  static void *operator new(std::size_t size);
+
+  /**
+    @internal
+  */
+  static void *operator new(std::size_t size, void *place) noexcept
+  {
+    Q_UNUSED(size);
+    return place;
+  }
+
+  /**
+    @internal
+  */
+  static void operator delete(void *ptr);
+
+  /**
+    @internal
+  */
+  static void operator delete(void *ptr, void *place) noexcept
+  {
+    Q_UNUSED(ptr);
+    Q_UNUSED(place);
+  }
 #endif
 
 protected:
@@ -0,0 +1,106 @@
+/*
+  This file is part of the Grantlee template system.
+
+  Copyright (c) 2026 agent <agent@local>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either version
+  2.1 of the Licence, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "nodearena_p.h"
+
+#include <algorithm>
+#include <new>
+
+using namespace Grantlee;
+
+namespace
+{
+// Each allocation is preceded by a header recording where it came from, so
+// that deallocate does not need to know the arena.
+enum AllocationKind : char { HeapAllocation, ArenaAllocation };
+
+const std::size_t s_headerSize = alignof(std::max_align_t);
+
+const std::size_t s_blockSize = 16 * 1024;
+
+thread_local NodeArena *s_currentArena = nullptr;
+}
+
+NodeArena::NodeArena(TemplateImpl *t)
+    : m_template(t), m_next(nullptr), m_remaining(0)
+{
+}
+
+NodeArena::~NodeArena()
+{
+  for (auto block : m_blocks)
+    ::operator delete(block);
+}
+
+void NodeArena::swap(NodeArena &other)
+{
+  Q_ASSERT(m_template == other.m_template);
+  std::swap(m_blocks, other.m_blocks);
+  std::swap(m_next, other.m_next);
+  std::swap(m_remaining, other.m_remaining);
+}
+
+NodeArena *NodeArena::current() { return s_currentArena; }
+
+char *NodeArena::allocateInBlock(std::size_t size)
+{
+  // Keep every allocation aligned for any type.
+  size = (size + s_headerSize - 1) & ~(s_headerSize - 1);
+  if (size > m_remaining) {
+    const auto blockSize = std::max(size, s_blockSize);
+    m_next = static_cast<char *>(::operator new(blockSize));
+    m_blocks.push_back(m_next);
+    m_remaining = blockSize;
+  }
+  auto result = m_next;
+  m_next += size;
+  m_remaining -= size;
+  return result;
+}
+
+void *NodeArena::allocate(std::size_t size)
+{
+  auto arena = s_currentArena;
+  char *block;
+  if (arena) {
+    block = arena->allocateInBlock(s_headerSize + size);
+    *block = ArenaAllocation;
+  } else {
+    block = static_cast<char *>(::operator new(s_headerSize + size));
+    *block = HeapAllocation;
+  }
+  return block + s_headerSize;
+}
+
+void NodeArena::deallocate(void *ptr)
+{
+  if (!ptr)
+    return;
+  auto block = static_cast<char *>(ptr) - s_headerSize;
+  if (*block == HeapAllocation)
+    ::operator delete(block);
+}
+
+NodeArena::Scope::Scope(NodeArena *arena) : m_previous(s_currentArena)
+{
+  s_currentArena = arena;
+}
+
+NodeArena::Scope::~Scope() { s_currentArena = m_previous; }
@@ -0,0 +1,110 @@
+/*
+  This file is part of the Grantlee template system.
+
+  Copyright (c) 2026 agent <agent@local>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either version
+  2.1 of the Licence, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef GRANTLEE_NODEARENA_P_H
+#define GRANTLEE_NODEARENA_P_H
+
+#include <QtCore/QtGlobal>
+
+#include <cstddef>
+#include <vector>
+
+namespace Grantlee
+{
+
+class TemplateImpl;
+
+/**
+  @internal
+
+  Storage for the nodes of one Template.
+
+  While a Template is being compiled its arena is made current with a
+  NodeArena::Scope. Node objects and their NodePrivate created in that time
+  are bump-allocated from a few large blocks owned by the arena, and record
+  the Template they belong to. The private data QObject allocates for each
+  node is still allocated separately. The blocks are released all at once
+  when the Template is destroyed or its content is replaced.
+
+  Nodes created while no arena is current, such as those created while
+  rendering, fall back to the heap.
+*/
+class NodeArena
+{
+public:
+  explicit NodeArena(TemplateImpl *t);
+  ~NodeArena();
+
+  /**
+    Returns the Template which owns this arena.
+  */
+  TemplateImpl *containerTemplate() const { return m_template; }
+
+  /**
+    Exchanges the blocks of this arena with those of @p other, which must
+    belong to the same Template.
+  */
+  void swap(NodeArena &other);
+
+  /**
+    Returns the arena which is current in this thread, if any.
+  */
+  static NodeArena *current();
+
+  /**
+    Allocates @p size bytes from the current arena, or from the heap if no
+    arena is current.
+  */
+  static void *allocate(std::size_t size);
+
+  /**
+    Releases @p ptr if it was allocated from the heap. Memory allocated from
+    an arena is released with the arena.
+  */
+  static void deallocate(void *ptr);
+
+  /**
+    Makes an arena current for the lifetime of the scope, and restores the
+    previously current arena afterwards.
+  */
+  class Scope
+  {
+  public:
+    explicit Scope(NodeArena *arena);
+    ~Scope();
+
+  private:
+    NodeArena *const m_previous;
+    Q_DISABLE_COPY(Scope)
+  };
+
+private:
+  char *allocateInBlock(std::size_t size);
+
+  TemplateImpl *const m_template;
+  std::vector<char *> m_blocks;
+  char *m_next;
+  std::size_t m_remaining;
+
+  Q_DISABLE_COPY(NodeArena)
+};
+}
+
+#endif
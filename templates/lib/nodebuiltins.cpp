@@ -34,7 +34,8 @@ VariableNode::VariableNode(const FilterExpression &fe, const Grantlee::Token& to
 
 void VariableNode::render(OutputStream *stream, Context *c) const
 {
-  const auto v = m_filterExpression.resolve(c);
+  // The last filter may already have written its result to the stream.
+  const auto v = m_filterExpression.resolveForOutput(stream, c);
   if (!v.isValid())
     return;
   streamValueInContext(stream, v, c);
@@ -56,7 +56,17 @@ public:
     m_plugin = qobject_cast<PluginType *>(m_object);
   }
 
-  QString errorString() { return m_pluginLoader->errorString(); }
+  // Wraps an already instantiated plugin, such as one which is linked
+  // statically, without a QPluginLoader.
+  explicit PluginPointer(QObject *object)
+      : m_object(object), m_plugin(qobject_cast<PluginType *>(object))
+  {
+  }
+
+  QString errorString()
+  {
+    return m_pluginLoader ? m_pluginLoader->errorString() : QString();
+  }
 
   QObject *object() { return m_object; }
 
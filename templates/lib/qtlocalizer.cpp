@@ -23,15 +23,113 @@
 #include <QtCore/QCoreApplication>
 #include <QtCore/QDateTime>
 #include <QtCore/QLibraryInfo>
+#include <QtCore/QReadWriteLock>
 #include <QtCore/QTranslator>
 #include <QtCore/QVector>
 
+#include <algorithm>
+#include <limits>
+
 #include <QtCore/QLoggingCategory>
 
 Q_LOGGING_CATEGORY(GRANTLEE_LOCALIZER, "grantlee.localizer")
 
+struct TranslationKey {
+  QString context;
+  QString input;
+  int count;
+};
+
+static bool operator==(const TranslationKey &lhs, const TranslationKey &rhs)
+{
+  return lhs.count == rhs.count && lhs.input == rhs.input
+         && lhs.context == rhs.context;
+}
+
+static uint qHash(const TranslationKey &key, uint seed = 0)
+{
+  return qHash(key.input, seed) ^ qHash(key.context, seed) ^ uint(key.count);
+}
+
+/**
+  A translated string, split once into the literal text and the %1 to %99
+  escapes which the arguments of the i18n tags are substituted into.
+*/
+class MessageFormat
+{
+public:
+  MessageFormat() : m_argumentCount(0), m_literalSize(0), m_ambiguous(false)
+  {
+  }
+
+  explicit MessageFormat(const QString &text);
+
+  QString substitute(const QVariantList &arguments) const;
+
+private:
+  struct Segment {
+    // The literal text, or the escape itself if this is an escape.
+    QString text;
+    // The rank of the escape among the distinct escape numbers, or -1 for
+    // literal text.
+    int argument;
+    bool localized;
+  };
+
+  QString m_text;
+  QVector<Segment> m_segments;
+  int m_argumentCount;
+  int m_literalSize;
+  // Whether substituting one argument could create a new escape, in which
+  // case the arguments are substituted one at a time like QString::arg does.
+  bool m_ambiguous;
+};
+
+// Distinct plural counts each take an entry, so the memo is bounded.
+static const int s_maxMemoizedTranslations = 10000;
+
+/**
+  Formats integers like QLocale does, from tables of the digits, signs and
+  grouping of a locale read once from QLocale itself.
+*/
+class NumberFormat
+{
+public:
+  explicit NumberFormat(const QLocale &locale);
+
+  bool isValid() const { return m_valid; }
+
+  QString toString(int number) const;
+
+private:
+  QString m_digits[10];
+  QString m_minus;
+  QString m_groupSeparator;
+  // The number of digits in the lowest group, or 0 if digits are not grouped.
+  int m_primaryGroupSize;
+  int m_secondaryGroupSize;
+  // The least number of digits which are grouped.
+  int m_minimumGroupedDigits;
+  bool m_valid;
+};
+
+static const int s_formatTypeCount = QLocale::NarrowFormat + 1;
+
 struct Locale {
-  explicit Locale(const QLocale &_locale) : locale(_locale) {}
+  explicit Locale(const QLocale &_locale)
+      : locale(_locale), numberFormat(_locale),
+        cacheFormats(_locale != QLocale::system())
+  {
+    // The system locale may format dates by asking the platform instead.
+    if (!cacheFormats)
+      return;
+    for (auto i = 0; i < s_formatTypeCount; ++i) {
+      const auto type = static_cast<QLocale::FormatType>(i);
+      dateFormats[i] = locale.dateFormat(type);
+      timeFormats[i] = locale.timeFormat(type);
+      dateTimeFormats[i] = locale.dateTimeFormat(type);
+    }
+  }
 
   ~Locale()
   {
@@ -39,10 +137,27 @@ struct Locale {
     qDeleteAll(themeTranslators);
   }
 
+  void clearFormats()
+  {
+    QWriteLocker locker(&formatsLock);
+    formats.clear();
+  }
+
   const QLocale locale;
+  const NumberFormat numberFormat;
+  const bool cacheFormats;
+  QString dateFormats[s_formatTypeCount];
+  QString timeFormats[s_formatTypeCount];
+  QString dateTimeFormats[s_formatTypeCount];
+
   QVector<QTranslator *> externalSystemTranslators; // Not owned by us!
   QVector<QTranslator *> systemTranslators;
   QVector<QTranslator *> themeTranslators;
+
+  // The translations looked up so far, with %n replaced. Cleared when the
+  // translators change.
+  QReadWriteLock formatsLock;
+  QHash<TranslationKey, MessageFormat> formats;
 };
 
 namespace Grantlee
@@ -73,11 +188,18 @@ class QtLocalizerPrivate
     return m_locales.last()->locale;
   }
 
+  const Locale *currentLocaleData() const
+  {
+    return m_locales.isEmpty() ? nullptr : m_locales.last();
+  }
+
   Q_DECLARE_PUBLIC(QtLocalizer)
   QtLocalizer *const q_ptr;
 
   QString translate(const QString &input, const QString &context,
                     int count = -1) const;
+  MessageFormat messageFormat(const QString &input, const QString &context,
+                              int count = -1) const;
 
   QHash<QString, Locale *> m_availableLocales;
 
@@ -126,20 +248,21 @@ QString QtLocalizerPrivate::translate(const QString &input,
   }
 
   auto locale = m_locales.last();
+  const auto utf8Input = input.toUtf8();
+  const auto utf8Context = context.toUtf8();
   for (QTranslator *translator : qAsConst(locale->themeTranslators)) {
-    result = translator->translate("GR_FILENAME", input.toUtf8().constData(),
-                                   context.toUtf8().constData(), count);
+    result = translator->translate("GR_FILENAME", utf8Input.constData(),
+                                   utf8Context.constData(), count);
   }
   if (result.isEmpty()) {
     auto translators
         = locale->externalSystemTranslators + locale->systemTranslators;
     if (translators.isEmpty())
-      return QCoreApplication::translate("GR_FILENAME",
-                                         input.toUtf8().constData(),
-                                         context.toUtf8().constData(), count);
+      return QCoreApplication::translate("GR_FILENAME", utf8Input.constData(),
+                                         utf8Context.constData(), count);
     for (QTranslator *translator : qAsConst(translators)) {
-      result = translator->translate("GR_FILENAME", input.toUtf8().constData(),
-                                     context.toUtf8().constData(), count);
+      result = translator->translate("GR_FILENAME", utf8Input.constData(),
+                                     utf8Context.constData(), count);
       if (!result.isEmpty())
         break;
     }
@@ -153,6 +276,114 @@ QString QtLocalizerPrivate::translate(const QString &input,
   return fallback;
 }
 
+NumberFormat::NumberFormat(const QLocale &locale)
+    : m_primaryGroupSize(0), m_secondaryGroupSize(0),
+      m_minimumGroupedDigits(0), m_valid(false)
+{
+  for (auto i = 0; i < 10; ++i)
+    m_digits[i] = locale.toString(i);
+
+  const auto minusOne = locale.toString(-1);
+  if (!minusOne.endsWith(m_digits[1]))
+    return;
+  m_minus = minusOne.left(minusOne.size() - m_digits[1].size());
+
+  if (!(locale.numberOptions() & QLocale::OmitGroupSeparator)) {
+    m_groupSeparator = QString(locale.groupSeparator());
+    const auto groups
+        = locale.toString(Q_INT64_C(1000000000000000000))
+              .split(m_groupSeparator);
+    if (groups.size() > 2) {
+      m_primaryGroupSize = groups.at(groups.size() - 1).size()
+                           / qMax(1, int(m_digits[0].size()));
+      m_secondaryGroupSize = groups.at(groups.size() - 2).size()
+                             / qMax(1, int(m_digits[0].size()));
+      qint64 power = 10;
+      for (auto digits = 2; digits < 10; ++digits, power *= 10) {
+        if (locale.toString(power).contains(m_groupSeparator)) {
+          m_minimumGroupedDigits = digits;
+          break;
+        }
+      }
+      if (m_primaryGroupSize == 0 || m_secondaryGroupSize == 0
+          || m_minimumGroupedDigits == 0)
+        return;
+    }
+  }
+
+  // Use the tables only if they reproduce QLocale exactly.
+  m_valid = true;
+  static const int probes[]
+      = {0,        7,         -7,         42,         123,
+         1234,     -1234,     12345,      123456,     1234567,
+         -1234567, 12345678,  123456789,  1000000000, -1000000000,
+         std::numeric_limits<int>::max(), std::numeric_limits<int>::min()};
+  for (const auto probe : probes) {
+    if (toString(probe) != locale.toString(probe)) {
+      m_valid = false;
+      return;
+    }
+  }
+}
+
+QString NumberFormat::toString(int number) const
+{
+  auto magnitude = number < 0 ? -qint64(number) : qint64(number);
+  char digits[10];
+  auto count = 0;
+  do {
+    digits[count++] = char(magnitude % 10);
+    magnitude /= 10;
+  } while (magnitude != 0);
+
+  const auto grouped
+      = m_primaryGroupSize != 0 && count >= m_minimumGroupedDigits;
+
+  QString result;
+  result.reserve(m_minus.size() + count * (m_digits[0].size() + 1));
+  if (number < 0)
+    result += m_minus;
+  for (auto remaining = count; remaining > 0; --remaining) {
+    if (grouped && remaining != count
+        && (remaining == m_primaryGroupSize
+            || (remaining > m_primaryGroupSize
+                && (remaining - m_primaryGroupSize) % m_secondaryGroupSize
+                       == 0)))
+      result += m_groupSeparator;
+    result += m_digits[int(digits[remaining - 1])];
+  }
+  return result;
+}
+
+MessageFormat QtLocalizerPrivate::messageFormat(const QString &input,
+                                                const QString &context,
+                                                int count) const
+{
+  // Without translators of our own, the translators installed on the
+  // application are used. Those may change at any time, so they are not
+  // memoized.
+  const auto locale = m_locales.isEmpty() ? nullptr : m_locales.last();
+  if (!locale
+      || (locale->externalSystemTranslators.isEmpty()
+          && locale->systemTranslators.isEmpty()))
+    return MessageFormat(translate(input, context, count));
+
+  const TranslationKey key{context, input, count};
+  {
+    QReadLocker locker(&locale->formatsLock);
+    const auto it = locale->formats.constFind(key);
+    if (it != locale->formats.constEnd())
+      return it.value();
+  }
+
+  const MessageFormat format(translate(input, context, count));
+  QWriteLocker locker(&locale->formatsLock);
+  if (locale->formats.size() >= s_maxMemoizedTranslations)
+    locale->formats.clear();
+  locale->formats.insert(key, format);
+  return format;
+}
+
 QtLocalizer::QtLocalizer(const QLocale &locale)
     : d_ptr(new QtLocalizerPrivate(this, locale))
 {
@@ -180,14 +411,21 @@ void QtLocalizer::installTranslator(QTranslator *translator,
     const QLocale namedLocale(localeName);
     d->m_availableLocales.insert(localeName, new Locale(namedLocale));
   }
-  d->m_availableLocales[localeName]->externalSystemTranslators.prepend(
-      translator);
+  auto locale = d->m_availableLocales[localeName];
+  locale->externalSystemTranslators.prepend(translator);
+  locale->clearFormats();
 }
 
 QString QtLocalizer::localizeDate(const QDate &date,
                                   QLocale::FormatType formatType) const
 {
   Q_D(const QtLocalizer);
+  const auto locale = d->currentLocaleData();
+  if (locale && locale->cacheFormats) {
+    if (!date.isValid())
+      return {};
+    return locale->locale.toString(date, locale->dateFormats[formatType]);
+  }
   return d->currentLocale().toString(date, formatType);
 }
 
@@ -195,6 +433,12 @@ QString QtLocalizer::localizeTime(const QTime &time,
                                   QLocale::FormatType formatType) const
 {
   Q_D(const QtLocalizer);
+  const auto locale = d->currentLocaleData();
+  if (locale && locale->cacheFormats) {
+    if (!time.isValid())
+      return {};
+    return locale->locale.toString(time, locale->timeFormats[formatType]);
+  }
   return d->currentLocale().toString(time, formatType);
 }
 
@@ -202,12 +446,22 @@ QString QtLocalizer::localizeDateTime(const QDateTime &dateTime,
                                       QLocale::FormatType formatType) const
 {
   Q_D(const QtLocalizer);
+  const auto locale = d->currentLocaleData();
+  if (locale && locale->cacheFormats) {
+    if (!dateTime.isValid())
+      return {};
+    return locale->locale.toString(dateTime,
+                                   locale->dateTimeFormats[formatType]);
+  }
   return d->currentLocale().toString(dateTime, formatType);
 }
 
 QString QtLocalizer::localizeNumber(int number) const
 {
   Q_D(const QtLocalizer);
+  const auto locale = d->currentLocaleData();
+  if (locale && locale->numberFormat.isValid())
+    return locale->numberFormat.toString(number);
   return d->currentLocale().toString(number);
 }
 
@@ -250,21 +504,145 @@ static QString substituteArguments(const QString &input,
   return string;
 }
 
+static QString argumentText(const QVariant &arg, bool localized)
+{
+  const auto escape = localized ? QStringLiteral("%L1") : QStringLiteral("%1");
+  if (arg.userType() == qMetaTypeId<int>())
+    return escape.arg(arg.value<int>());
+  if (arg.userType() == qMetaTypeId<double>())
+    return escape.arg(arg.value<double>());
+  if (arg.userType() == qMetaTypeId<QDateTime>())
+    return arg.value<QDateTime>().toString();
+  return arg.value<QString>();
+}
+
+MessageFormat::MessageFormat(const QString &text)
+    : m_text(text), m_argumentCount(0), m_literalSize(0), m_ambiguous(false)
+{
+  // Find the escapes the way QString::arg does.
+  QVector<int> numbers;
+  const auto size = text.size();
+  auto literalStart = 0;
+  auto pos = 0;
+  while (pos < size) {
+    pos = text.indexOf(QLatin1Char('%'), pos);
+    if (pos == -1)
+      break;
+    const auto escapeStart = pos;
+    if (++pos == size)
+      break;
+    auto localized = false;
+    if (text.at(pos) == QLatin1Char('L')) {
+      localized = true;
+      if (++pos == size)
+        break;
+    }
+    auto number = text.at(pos).digitValue();
+    if (number == -1)
+      continue;
+    ++pos;
+    auto digits = 1;
+    if (pos != size && text.at(pos).digitValue() != -1) {
+      number = 10 * number + text.at(pos).digitValue();
+      ++digits;
+      ++pos;
+    }
+
+    if (escapeStart > literalStart) {
+      m_segments.push_back(
+          {text.mid(literalStart, escapeStart - literalStart), -1, false});
+      m_literalSize += escapeStart - literalStart;
+    }
+    // A preceding % or %L, or a following escape after a single digit, could
+    // form a new escape with the substituted text.
+    if ((escapeStart > 0 && text.at(escapeStart - 1) == QLatin1Char('%'))
+        || (escapeStart > 1 && text.at(escapeStart - 1) == QLatin1Char('L')
+            && text.at(escapeStart - 2) == QLatin1Char('%'))
+        || (digits == 1 && pos != size && text.at(pos) == QLatin1Char('%')))
+      m_ambiguous = true;
+
+    m_segments.push_back(
+        {text.mid(escapeStart, pos - escapeStart), number, localized});
+    if (!numbers.contains(number))
+      numbers.push_back(number);
+    literalStart = pos;
+  }
+  if (literalStart < size) {
+    m_segments.push_back({text.mid(literalStart), -1, false});
+    m_literalSize += size - literalStart;
+  }
+
+  // QString::arg substitutes the lowest escape number first.
+  std::sort(numbers.begin(), numbers.end());
+  for (auto &segment : m_segments) {
+    if (segment.argument != -1)
+      segment.argument = int(std::lower_bound(numbers.constBegin(),
+                                              numbers.constEnd(),
+                                              segment.argument)
+                             - numbers.constBegin());
+  }
+  m_argumentCount = numbers.size();
+}
+
+QString MessageFormat::substitute(const QVariantList &arguments) const
+{
+  if (arguments.isEmpty())
+    return m_text;
+  if (m_ambiguous)
+    return substituteArguments(m_text, arguments);
+
+  const auto count = qMin(int(arguments.size()), m_argumentCount);
+  QVector<QString> texts(count);
+  QVector<QString> localizedTexts(count);
+  auto size = m_literalSize;
+  for (const auto &segment : m_segments) {
+    if (segment.argument == -1)
+      continue;
+    if (segment.argument >= count) {
+      size += segment.text.size();
+      continue;
+    }
+    auto &argText = segment.localized ? localizedTexts[segment.argument]
+                                      : texts[segment.argument];
+    if (argText.isNull()) {
+      argText = argumentText(arguments.at(segment.argument), segment.localized);
+      // The substituted text would be scanned for escapes by the following
+      // arguments.
+      if (argText.contains(QLatin1Char('%')))
+        return substituteArguments(m_text, arguments);
+      // Keep empty texts distinguishable from ones not computed yet.
+      if (argText.isNull())
+        argText = QLatin1String("");
+    }
+    size += argText.size();
+  }
+
+  QString result;
+  result.reserve(size);
+  for (const auto &segment : m_segments) {
+    if (segment.argument == -1 || segment.argument >= count)
+      result += segment.text;
+    else if (segment.localized)
+      result += localizedTexts.at(segment.argument);
+    else
+      result += texts.at(segment.argument);
+  }
+  return result;
+}
+
 QString QtLocalizer::localizeContextString(const QString &string,
                                            const QString &context,
                                            const QVariantList &arguments) const
 {
   Q_D(const QtLocalizer);
-  const auto translated = d->translate(string, context);
-  return substituteArguments(translated, arguments);
+  return d->messageFormat(string, context).substitute(arguments);
 }
 
 QString QtLocalizer::localizeString(const QString &string,
                                     const QVariantList &arguments) const
 {
   Q_D(const QtLocalizer);
-  const auto translated = d->translate(string, QString());
-  return substituteArguments(translated, arguments);
+  return d->messageFormat(string, QString()).substitute(arguments);
 }
 
 QString QtLocalizer::localizePluralContextString(
@@ -275,8 +653,7 @@ QString QtLocalizer::localizePluralContextString(
   Q_D(const QtLocalizer);
   auto arguments = _arguments;
   const auto N = arguments.takeFirst().toInt();
-  const auto translated = d->translate(string, context, N);
-  return substituteArguments(translated, arguments);
+  return d->messageFormat(string, context, N).substitute(arguments);
 }
 
 QString QtLocalizer::localizePluralString(const QString &string,
@@ -287,8 +664,7 @@ QString QtLocalizer::localizePluralString(const QString &string,
   Q_D(const QtLocalizer);
   auto arguments = _arguments;
   const auto N = arguments.takeFirst().toInt();
-  const auto translated = d->translate(string, QString(), N);
-  return substituteArguments(translated, arguments);
+  return d->messageFormat(string, QString(), N).substitute(arguments);
 }
 
 QString QtLocalizer::currentLocale() const
@@ -342,6 +718,7 @@ void QtLocalizer::loadCatalog(const QString &path, const QString &catalog)
     translator->setObjectName(catalog);
 
     it.value()->themeTranslators.prepend(translator);
+    it.value()->clearFormats();
   }
 }
 
@@ -360,5 +737,6 @@ void QtLocalizer::unloadCatalog(const QString &catalog)
         ++tranIt;
       }
     }
+    (*it)->clearFormats();
   }
 }
@@ -67,3 +67,9 @@ void RenderContext::pop()
   Q_D(RenderContext);
   d->m_variantHashStack.removeFirst();
 }
+
+int RenderContext::depth() const
+{
+  Q_D(const RenderContext);
+  return d->m_variantHashStack.size();
+}
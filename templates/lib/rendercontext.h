@@ -69,9 +69,12 @@ private:
 
   void pop();
 
+  int depth() const;
+
 private:
   friend class ContextPrivate;
   friend class TemplateImpl;
+  friend class TemplatePrivate;
 
   Q_DISABLE_COPY(RenderContext)
   Q_DECLARE_PRIVATE(RenderContext)
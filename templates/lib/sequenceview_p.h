@@ -0,0 +1,204 @@
+/*
+  This file is part of the Grantlee template system.
+
+  Copyright (c) 2026 agent <agent@local>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either version
+  2.1 of the Licence, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef GRANTLEE_SEQUENCEVIEW_P_H
+#define GRANTLEE_SEQUENCEVIEW_P_H
+
+#include "forwarditerable_p.h"
+#include "modelrows_p.h"
+
+#include <QtCore/QSequentialIterable>
+#include <QtCore/QVariant>
+
+namespace Grantlee
+{
+
+/**
+  A view of the items of a sequential container held in a QVariant, of the
+  rows of a QAbstractItemModel, or of the items of a value created by
+  Context::forwardIterable.
+
+  Converting such a QVariant to a QVariantList copies every item of any
+  container other than a QVariantList into a new list. The view instead reads
+  the items from the container in place, so that a large QVector or
+  std::vector of a registered type can be counted, indexed and iterated
+  without copying it.
+
+  The view keeps the QVariant it is created from, as the items are read from
+  its storage. It can not be copied for the same reason.
+*/
+class SequenceView
+{
+public:
+  class const_iterator
+  {
+  public:
+    QVariant operator*() const
+    {
+      return m_view->m_rows.isValid() ? m_view->m_rows.at(m_row) : *m_it;
+    }
+
+    bool operator==(const const_iterator &other) const
+    {
+      return m_view->m_rows.isValid() ? m_row == other.m_row
+                                      : m_it == other.m_it;
+    }
+
+    bool operator!=(const const_iterator &other) const
+    {
+      return !(*this == other);
+    }
+
+    const_iterator &operator++() { return *this += 1; }
+
+    const_iterator &operator--() { return *this -= 1; }
+
+    const_iterator &operator+=(int n)
+    {
+      m_row += n;
+      if (!m_view->m_rows.isValid())
+        m_it += n;
+      return *this;
+    }
+
+    const_iterator &operator-=(int n)
+    {
+      m_row -= n;
+      if (!m_view->m_rows.isValid())
+        m_it -= n;
+      return *this;
+    }
+
+    const_iterator operator+(int n) const
+    {
+      auto it = *this;
+      return it += n;
+    }
+
+    const_iterator operator-(int n) const
+    {
+      auto it = *this;
+      return it -= n;
+    }
+
+  private:
+    friend class SequenceView;
+
+    const_iterator(const SequenceView *view, int row,
+                   const QSequentialIterable::const_iterator &it)
+        : m_view(view), m_row(row), m_it(it)
+    {
+    }
+
+    const SequenceView *m_view;
+    int m_row;
+    QSequentialIterable::const_iterator m_it;
+  };
+
+  explicit SequenceView(const QVariant &value)
+      : m_rows(ModelRows::fromVariant(value)),
+        m_isValid(m_rows.isValid() || isForwardIterable(value)
+                  || value.canConvert<QVariantList>()),
+        m_value(viewedValue(value, m_isValid && !m_rows.isValid())),
+        m_iterable(m_value.value<QSequentialIterable>())
+  {
+  }
+
+  static bool isForwardIterable(const QVariant &value)
+  {
+    return value.userType() == qMetaTypeId<ForwardIterable>();
+  }
+
+  /**
+    Returns whether the viewed value is a sequential container or a model.
+  */
+  bool isValid() const { return m_isValid; }
+
+  int size() const
+  {
+    if (m_rows.isValid())
+      return m_rows.size();
+    return int(m_iterable.size());
+  }
+
+  bool isEmpty() const
+  {
+    if (m_rows.isValid())
+      return !m_rows.hasRow(0);
+    return size() == 0;
+  }
+
+  QVariant at(int index) const
+  {
+    if (m_rows.isValid())
+      return m_rows.at(index);
+    return m_iterable.at(index);
+  }
+
+  const_iterator begin() const
+  {
+    return const_iterator(this, 0, m_iterable.begin());
+  }
+
+  /**
+    Returns the iterator past the last item. For a model, all rows are
+    fetched first.
+  */
+  const_iterator end() const
+  {
+    return const_iterator(this, m_rows.isValid() ? m_rows.size() : 0,
+                          m_iterable.end());
+  }
+
+  /**
+    Returns whether an item of the container equals @p needle.
+  */
+  bool contains(const QVariant &needle) const
+  {
+    const auto end = this->end();
+    for (auto it = begin(); it != end; ++it)
+      if (*it == needle)
+        return true;
+    return false;
+  }
+
+private:
+  Q_DISABLE_COPY(SequenceView)
+
+  static QVariant viewedValue(const QVariant &value, bool isSequence)
+  {
+    // The rows of a model are not read through the iterable, which then
+    // views an empty list.
+    if (!isSequence)
+      return QVariant(QVariantList());
+    // Items which can only be iterated once are collected to be indexed.
+    if (isForwardIterable(value))
+      return value.value<ForwardIterable>().toList();
+    return value;
+  }
+
+  const ModelRows m_rows;
+  const bool m_isValid;
+  const QVariant m_value;
+  const QSequentialIterable m_iterable;
+};
+}
+
+#endif
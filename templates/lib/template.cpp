@@ -23,12 +23,18 @@
 
 #include "context.h"
 #include "engine.h"
+#include "engine_p.h"
 #include "exception.h"
 #include "lexer_p.h"
+#include "node.h"
 #include "parser.h"
 #include "rendercontext.h"
 
+#include <QtCore/QAtomicInt>
 #include <QtCore/QLoggingCategory>
+#include <QtCore/QRunnable>
+#include <QtCore/QSemaphore>
+#include <QtCore/QThreadPool>
 
 Q_LOGGING_CATEGORY(GRANTLEE_TEMPLATE, "grantlee.template")
 
@@ -37,6 +43,7 @@ using namespace Grantlee;
 NodeList TemplatePrivate::compileString(const QString &str)
 {
   Q_Q(TemplateImpl);
+  const NodeArena::Scope arenaScope(&m_nodeArena);
   Lexer l(str);
   Parser p(l.tokenize(m_smartTrim ? Lexer::SmartTrim : Lexer::NoSmartTrim), q);
 
@@ -54,7 +61,13 @@ TemplateImpl::TemplateImpl(Engine const *engine, bool smartTrim,
 {
 }
 
-TemplateImpl::~TemplateImpl() { delete d_ptr; }
+TemplateImpl::~TemplateImpl()
+{
+  // The nodes may live in the arena of the private, so destroy them first.
+  const auto nodes = children();
+  qDeleteAll(nodes);
+  delete d_ptr;
+}
 
 void TemplateImpl::setContent(const QString &templateString)
 {
@@ -62,13 +75,54 @@ void TemplateImpl::setContent(const QString &templateString)
   if (templateString.isEmpty())
     return;
 
+  // The new content is compiled into an empty arena. The nodes of the content
+  // it replaces are destroyed afterwards, together with their arena.
+  const auto previousNodes
+      = findChildren<Node *>(QString(), Qt::FindDirectChildrenOnly);
+  NodeArena previousArena(this);
+  previousArena.swap(d->m_nodeArena);
+
   try {
     d->m_nodeList = d->compileString(templateString);
     d->setError(NoError, QString(),-1,-1,QString());
   } catch (Grantlee::Exception &e) {
     qCWarning(GRANTLEE_TEMPLATE) << e.what();
     d->setError(e.errorCode(), e.what(), e.errorLine(), e.errorColumn(), e.errorTokenContent());
+
+    // The previous content is kept.
+    const auto nodes
+        = findChildren<Node *>(QString(), Qt::FindDirectChildrenOnly);
+    for (auto node : nodes) {
+      if (!previousNodes.contains(node))
+        delete node;
+    }
+    d->m_nodeArena.swap(previousArena);
+    return;
   }
+
+  qDeleteAll(previousNodes);
+}
+
+void TemplatePrivate::renderNodes(OutputStream *stream, Context *c) const
+{
+  const TemplateGenerationScope generationScope(this);
+
+  c->clearExternalMedia();
+
+  // Included templates share the lazy values of the outermost render.
+  if (c->renderContext()->depth() == 0)
+    c->resetLazyValues();
+
+  c->renderContext()->push();
+
+  try {
+    m_nodeList.render(stream, c);
+  } catch (...) {
+    c->renderContext()->pop();
+    throw;
+  }
+
+  c->renderContext()->pop();
 }
 
 QString TemplateImpl::render(Context *c) const
@@ -84,21 +138,234 @@ OutputStream *TemplateImpl::render(OutputStream *stream, Context *c) const
 {
   Q_D(const Template);
 
+  try {
+    d->renderNodes(stream, c);
+    d->setError(NoError, QString(),-1,-1,QString());
+  } catch (Grantlee::Exception &e) {
+    qCWarning(GRANTLEE_TEMPLATE) << e.what();
+    d->setError(e.errorCode(), e.what(), e.errorLine(), e.errorColumn(), e.errorTokenContent());
+  }
+
+  return stream;
+}
+
+static bool dependsOnAny(const RenderedSection &section,
+                         const QStringList &changedKeys)
+{
+  for (const auto &key : changedKeys) {
+    for (const auto &dependency : section.dependencies) {
+      if (dependency == key
+          || (dependency.startsWith(key)
+              && dependency.at(key.size()) == QLatin1Char('.'))
+          || (key.startsWith(dependency)
+              && key.at(dependency.size()) == QLatin1Char('.')))
+        return true;
+    }
+  }
+  return false;
+}
+
+QString TemplatePrivate::renderSections(Context *c,
+                                        const QStringList *changedKeys,
+                                        RenderedSections *sections) const
+{
+  // Sections recorded for another template can not be reused.
+  if (sections->size() != m_nodeList.size()) {
+    changedKeys = nullptr;
+    sections->resize(m_nodeList.size());
+  }
+
+  const TemplateGenerationScope generationScope(this);
+
   c->clearExternalMedia();
 
+  if (c->renderContext()->depth() == 0)
+    c->resetLazyValues();
+
   c->renderContext()->push();
 
+  // The names inserted by the sections rendered again are changed for the
+  // sections after them.
+  QStringList changed;
+  if (changedKeys)
+    changed = *changedKeys;
+
+  QString output;
   try {
-    d->m_nodeList.render(stream, c);
-    d->setError(NoError, QString(),-1,-1,QString());
+    for (auto i = 0; i < m_nodeList.size(); ++i) {
+      auto &section = (*sections)[i];
+      if (changedKeys && section.insertions.isEmpty()
+          && !dependsOnAny(section, changed)) {
+        output += section.output;
+        continue;
+      }
+      section.output.clear();
+      section.dependencies.clear();
+      section.insertions.clear();
+
+      QTextStream textStream(&section.output);
+      OutputStream outputStream(&textStream);
+      c->setLookupRecorder(&section.dependencies, &section.insertions);
+      m_nodeList.at(i)->render(&outputStream, c);
+      textStream.flush();
+
+      output += section.output;
+      for (const auto &name : qAsConst(section.insertions))
+        changed.append(name);
+    }
+    setError(NoError, QString(), -1, -1, QString());
   } catch (Grantlee::Exception &e) {
     qCWarning(GRANTLEE_TEMPLATE) << e.what();
-    d->setError(e.errorCode(), e.what(), e.errorLine(), e.errorColumn(), e.errorTokenContent());
+    setError(e.errorCode(), e.what(), e.errorLine(), e.errorColumn(),
+             e.errorTokenContent());
   }
 
+  c->setLookupRecorder(nullptr);
   c->renderContext()->pop();
 
-  return stream;
+  return output;
+}
+
+QString TemplateImpl::renderTracked(Context *c,
+                                    RenderedSections *sections) const
+{
+  Q_D(const Template);
+  sections->clear();
+  return d->renderSections(c, nullptr, sections);
+}
+
+QString TemplateImpl::rerender(Context *c, const QStringList &changedKeys,
+                               RenderedSections *sections) const
+{
+  Q_D(const Template);
+  return d->renderSections(c, &changedKeys, sections);
+}
+
+namespace Grantlee
+{
+
+struct BatchRenderError {
+  BatchRenderError() : type(NoError), line(-1), column(-1) {}
+
+  Error type;
+  QString message;
+  int line;
+  int column;
+  QString tokenContent;
+};
+
+/**
+  The shared state of a batch render. Each thread claims the next item with
+  the atomic counter, so that the work is balanced without a task per item.
+*/
+struct BatchRenderState {
+  BatchRenderState(const QList<Context *> &contexts,
+                   const QList<OutputStream *> *streams, QString *outputs)
+      : contexts(contexts), streams(streams), outputs(outputs),
+        errors(contexts.size())
+  {
+  }
+
+  const QList<Context *> &contexts;
+  // Either one stream per item, or the strings to render into.
+  const QList<OutputStream *> *const streams;
+  QString *const outputs;
+  QVector<BatchRenderError> errors;
+  QAtomicInt next;
+  QSemaphore finished;
+};
+
+class BatchRenderJob : public QRunnable
+{
+public:
+  BatchRenderJob(const TemplatePrivate *d, BatchRenderState *state)
+      : m_d(d), m_state(state)
+  {
+  }
+
+  void run() override
+  {
+    m_d->renderBatchItems(m_state);
+    m_state->finished.release();
+  }
+
+private:
+  const TemplatePrivate *const m_d;
+  BatchRenderState *const m_state;
+};
+}
+
+void TemplatePrivate::renderBatchItems(BatchRenderState *state) const
+{
+  const auto count = static_cast<int>(state->contexts.size());
+  auto errors = state->errors.data();
+  for (auto i = state->next.fetchAndAddRelaxed(1); i < count;
+       i = state->next.fetchAndAddRelaxed(1)) {
+    auto c = state->contexts.at(i);
+    try {
+      if (state->streams) {
+        renderNodes(state->streams->at(i), c);
+      } else {
+        QTextStream textStream(&state->outputs[i]);
+        OutputStream outputStream(&textStream);
+        renderNodes(&outputStream, c);
+      }
+    } catch (Grantlee::Exception &e) {
+      qCWarning(GRANTLEE_TEMPLATE) << e.what();
+      auto &error = errors[i];
+      error.type = e.errorCode();
+      error.message = e.what();
+      error.line = e.errorLine();
+      error.column = e.errorColumn();
+      error.tokenContent = e.errorTokenContent();
+    }
+  }
+}
+
+void TemplatePrivate::renderBatch(const QList<Context *> &contexts,
+                                  const QList<OutputStream *> *streams,
+                                  QString *outputs, QThreadPool *pool) const
+{
+  if (!pool)
+    pool = QThreadPool::globalInstance();
+
+  BatchRenderState state(contexts, streams, outputs);
+
+  // The calling thread renders too, so one job fewer is started.
+  const auto jobs
+      = qMax(0, qMin(pool->maxThreadCount(), int(contexts.size())) - 1);
+  for (auto i = 0; i < jobs; ++i)
+    pool->start(new BatchRenderJob(this, &state));
+
+  renderBatchItems(&state);
+  state.finished.acquire(jobs);
+
+  for (const auto &error : state.errors) {
+    if (error.type != NoError) {
+      setError(error.type, error.message, error.line, error.column,
+               error.tokenContent);
+      return;
+    }
+  }
+  setError(NoError, QString(), -1, -1, QString());
+}
+
+QStringList TemplateImpl::renderBatch(const QList<Context *> &contexts,
+                                      QThreadPool *pool) const
+{
+  Q_D(const Template);
+  QVector<QString> outputs(contexts.size());
+  d->renderBatch(contexts, nullptr, outputs.data(), pool);
+  return outputs.toList();
+}
+
+void TemplateImpl::renderBatch(const QList<OutputStream *> &streams,
+                               const QList<Context *> &contexts,
+                               QThreadPool *pool) const
+{
+  Q_D(const Template);
+  Q_ASSERT(streams.size() == contexts.size());
+  d->renderBatch(contexts, &streams, nullptr, pool);
 }
 
 NodeList TemplateImpl::nodeList() const
@@ -115,6 +382,7 @@ void TemplateImpl::setNodeList(const NodeList &list)
 
 void TemplatePrivate::setError(Error type, const QString &message, const int line, const int column, const QString &tokenContent) const
 {
+  QMutexLocker locker(&m_errorMutex);
   m_error = type;
   m_errorString = message;
   m_errorLine = line;
@@ -125,30 +393,35 @@ void TemplatePrivate::setError(Error type, const QString &message, const int lin
 Error TemplateImpl::error() const
 {
   Q_D(const Template);
+  QMutexLocker locker(&d->m_errorMutex);
   return d->m_error;
 }
 
 QString TemplateImpl::errorString() const
 {
   Q_D(const Template);
+  QMutexLocker locker(&d->m_errorMutex);
   return d->m_errorString;
 }
 
 int TemplateImpl::errorColumn() const
 {
     Q_D(const Template);
+    QMutexLocker locker(&d->m_errorMutex);
     return d->m_errorColumn;
 }
 
 int TemplateImpl::errorLine() const
 {
     Q_D(const Template);
+    QMutexLocker locker(&d->m_errorMutex);
     return d->m_errorLine;
 }
 
 QString TemplateImpl::errorTokenContent() const
 {
     Q_D(const Template);
+    QMutexLocker locker(&d->m_errorMutex);
     return d->m_errorTokenContent;
 }
 
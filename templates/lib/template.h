@@ -25,8 +25,12 @@
 #include "grantlee_templates_export.h"
 #include "node.h"
 
+#include <QtCore/QSet>
 #include <QtCore/QSharedPointer>
 #include <QtCore/QStringList>
+#include <QtCore/QVector>
+
+class QThreadPool;
 
 namespace Grantlee
 {
@@ -45,6 +49,40 @@ class TemplatePrivate;
 
 /// @headerfile template.h grantlee/template.h
 
+/**
+  @brief The output of one top level node of a Template, and the Context
+  lookups it depends on.
+
+  @see TemplateImpl::renderTracked
+*/
+struct RenderedSection {
+  /**
+    The rendered output of the node.
+  */
+  QString output;
+
+  /**
+    The names looked up in the Context while rendering the node, and the
+    lookup paths of variables such as <tt>"person.name"</tt>.
+  */
+  QSet<QString> dependencies;
+
+  /**
+    The names the node inserted into the Context for the nodes after it, as
+    with <tt>{% regroup people by gender as groups %}</tt>. A node which
+    inserts names is always rendered again, and the nodes depending on the
+    names it inserted too.
+  */
+  QSet<QString> insertions;
+};
+
+/**
+  The sections of a Template rendered with TemplateImpl::renderTracked.
+*/
+typedef QVector<RenderedSection> RenderedSections;
+
+/// @headerfile template.h grantlee/template.h
+
 /**
   @brief The **%Template** class is a tree of nodes which may be rendered.
 
@@ -90,6 +128,28 @@ class TemplatePrivate;
   If there is an error in parsing or rendering, the @ref error and @ref
   errorString methods can be used to check the source of the error.
 
+  Where only some of the data in a Context changes between renders, the
+  @ref renderTracked and @ref rerender methods can be used to render again
+  only the parts of the **%Template** which depend on the changed data.
+
+  @code
+    RenderedSections sections;
+    auto output = t->renderTracked( &c, &sections );
+
+    c.insert( "status", newStatus );
+    output = t->rerender( &c, { "status" }, &sections );
+  @endcode
+
+  When many outputs are rendered from the same **%Template**, the
+  @ref renderBatch methods render them on the threads of a QThreadPool, sharing
+  the parsed nodes.
+
+  @code
+    QList<Context *> contexts;
+    // ... one Context per recipient
+    const auto outputs = t->renderBatch(contexts);
+  @endcode
+
   @author Stephen Kelly <steveire@gmail.com>
 */
 class GRANTLEE_TEMPLATES_EXPORT TemplateImpl : public QObject
@@ -108,6 +168,55 @@ public:
   */
   OutputStream *render(OutputStream *stream, Context *c) const;
 
+  /**
+    Renders the **%Template** to a string given the Context @p c, recording
+    the output and the dependencies of each top level node in @p sections.
+
+    A **%Template** which uses the @gr_tag{extends} tag has a single top level
+    node, so it is always rendered as a whole.
+  */
+  QString renderTracked(Context *c, RenderedSections *sections) const;
+
+  /**
+    Renders the **%Template** to a string given the Context @p c, reusing the
+    output in @p sections for the top level nodes which do not depend on any
+    of @p changedKeys, and updating @p sections for the others.
+
+    A key such as <tt>"person"</tt> also matches lookups of
+    <tt>"person.name"</tt>, and the other way around.
+
+    @p sections must have been filled by @ref renderTracked for this
+    **%Template**.
+  */
+  QString rerender(Context *c, const QStringList &changedKeys,
+                   RenderedSections *sections) const;
+
+  /**
+    Renders the **%Template** once for each Context in @p contexts and returns
+    the outputs in the same order.
+
+    The contexts are rendered concurrently on the threads of @p pool, or of
+    QThreadPool::globalInstance() if @p pool is null. The calling thread takes
+    part in the rendering too, and must not itself be a thread of @p pool.
+
+    Each Context must be distinct. If rendering fails for any of them, @ref
+    error describes the first failure in the order of @p contexts.
+  */
+  QStringList renderBatch(const QList<Context *> &contexts,
+                          QThreadPool *pool = {}) const;
+
+  /**
+    Renders the **%Template** once for each Context in @p contexts to the
+    OutputStream at the same position in @p streams.
+
+    This is like the other overload, but avoids collecting every output in
+    memory. @p streams and @p contexts must have the same size, and each
+    stream is only written to by a single thread.
+  */
+  void renderBatch(const QList<OutputStream *> &streams,
+                   const QList<Context *> &contexts,
+                   QThreadPool *pool = {}) const;
+
 #ifndef Q_QDOC
   /**
     @internal
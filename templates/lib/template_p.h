@@ -22,29 +22,45 @@
 #define GRANTLEE_TEMPLATE_P_H
 
 #include "engine.h"
+#include "nodearena_p.h"
 #include "template.h"
 
+#include <QtCore/QMutex>
 #include <QtCore/QPointer>
 
+class QThreadPool;
+
 namespace Grantlee
 {
 
 class Engine;
+struct BatchRenderState;
+struct TemplateGeneration;
 
 class TemplatePrivate
 {
   TemplatePrivate(Engine const *engine, bool smartTrim, TemplateImpl *t)
-      : q_ptr(t), m_error(NoError), m_smartTrim(smartTrim), m_engine(engine)
+      : q_ptr(t), m_error(NoError), m_smartTrim(smartTrim), m_engine(engine),
+        m_nodeArena(t)
   {
   }
 
   void parse();
   NodeList compileString(const QString &str);
+  void renderNodes(OutputStream *stream, Context *c) const;
+  void renderBatch(const QList<Context *> &contexts,
+                   const QList<OutputStream *> *streams, QString *outputs,
+                   QThreadPool *pool) const;
+  void renderBatchItems(BatchRenderState *state) const;
+  QString renderSections(Context *c, const QStringList *changedKeys,
+                         RenderedSections *sections) const;
   void setError(Error type, const QString &message, const int line, const int column, const QString &tokenContent) const;
 
   Q_DECLARE_PUBLIC(TemplateImpl)
   TemplateImpl *const q_ptr;
 
+  // Templates which are included may be rendered on several threads at once.
+  mutable QMutex m_errorMutex;
   mutable Error m_error;
   mutable QString m_errorString;
   mutable int m_errorLine;
@@ -53,9 +69,15 @@ class TemplatePrivate
   NodeList m_nodeList;
   bool m_smartTrim;
   QPointer<const Engine> m_engine;
+  NodeArena m_nodeArena;
+  // The generation the template was loaded in, if the Engine reloads
+  // templates. Guarded by the loader mutex of the Engine.
+  QWeakPointer<TemplateGeneration> m_generation;
 
   friend class Grantlee::Engine;
   friend class Parser;
+  friend class BatchRenderJob;
+  friend class TemplateGenerationScope;
 };
 }
 
@@ -43,6 +43,10 @@ class AbstractLocalizer;
   TemplateLoaders will typically be created, configured and added to the
   Grantlee::Engine which will call the appropriate API.
 
+  Templates may load other templates while they are rendered, so if Templates
+  are rendered on several threads, implementations must be safe to call from
+  several threads at once.
+
   @author Stephen Kelly <steveire@gmail.com>
 */
 class GRANTLEE_TEMPLATES_EXPORT AbstractTemplateLoader
@@ -21,6 +21,8 @@
 #include "typeaccessor.h"
 
 #include "metaenumvariable_p.h"
+#include "metatype.h"
+#include "modelrows_p.h"
 #include "safestring.h"
 
 #include <QtCore/QRegularExpression>
@@ -44,131 +46,167 @@ static QRegularExpression getTitleRE()
   return titleRe;
 }
 
-template <>
-QVariant
-TypeAccessor<Grantlee::SafeString &>::lookUp(const Grantlee::SafeString &object,
-                                             const QString &property)
-{
-  if (property == QStringLiteral("capitalize")) {
-    const QString &s = object.get();
-    return {s.at(0).toUpper() + s.right(s.length() - 1)};
-  }
+static const QLatin1String falseString("False");
+static const QLatin1String trueString("True");
 
-  static const QLatin1String falseString("False");
-  static const QLatin1String trueString("True");
+static QVariant capitalize(const Grantlee::SafeString &object)
+{
+  const QString &s = object.get();
+  return {s.at(0).toUpper() + s.right(s.length() - 1)};
+}
 
-  if (property == QStringLiteral("isalnum")) {
-    const QString &s = object.get();
-    auto it = s.constBegin();
-    while (it != s.constEnd()) {
-      if (!it->isLetterOrNumber())
-        return falseString;
-      ++it;
-    }
-    return trueString;
-  }
-  if (property == QStringLiteral("isalpha")) {
-    const QString &s = object.get();
-    auto it = s.constBegin();
-    if (it == s.constEnd())
+static QVariant isAlnum(const Grantlee::SafeString &object)
+{
+  const QString &s = object.get();
+  auto it = s.constBegin();
+  while (it != s.constEnd()) {
+    if (!it->isLetterOrNumber())
       return falseString;
-    while (it != s.constEnd()) {
-      if (!it->isLetter())
-        return falseString;
-      ++it;
-    }
-    return trueString;
+    ++it;
   }
-  if (property == QStringLiteral("isdigit")) {
-    const QString &s = object.get();
-    auto it = s.constBegin();
-    while (it != s.constEnd()) {
-      if (!it->isNumber())
-        return falseString;
-      ++it;
-    }
-    return trueString;
-  }
-  if (property == QStringLiteral("islower")) {
-    const QString s = object.get().toLower();
-    return (s == object.get()) ? trueString : falseString;
-  }
-  if (property == QStringLiteral("isspace")) {
-    const QString s = object.get().trimmed();
-    return (s.isEmpty()) ? trueString : falseString;
-  }
-  if (property == QStringLiteral("istitle")) {
-    const QString &s = object.get();
+  return trueString;
+}
 
-    static const auto titleRe = getIsTitleRE();
-    return (titleRe.match(s).hasMatch()) ? falseString : trueString;
-  }
-  if (property == QStringLiteral("isupper")) {
-    const QString s = object.get().toUpper();
-    return (s == object) ? trueString : falseString;
-  }
-  if (property == QStringLiteral("lower")) {
-    return object.get().toLower();
+static QVariant isAlpha(const Grantlee::SafeString &object)
+{
+  const QString &s = object.get();
+  auto it = s.constBegin();
+  if (it == s.constEnd())
+    return falseString;
+  while (it != s.constEnd()) {
+    if (!it->isLetter())
+      return falseString;
+    ++it;
   }
-  if (property == QStringLiteral("splitlines")) {
-    const auto strings = object.get().split(QLatin1Char('\n'));
-    QVariantList list;
-    auto it = strings.constBegin();
-    const auto end = strings.constEnd();
-    for (; it != end; ++it)
-      list << *it;
-    return list;
+  return trueString;
+}
+
+static QVariant isDigit(const Grantlee::SafeString &object)
+{
+  const QString &s = object.get();
+  auto it = s.constBegin();
+  while (it != s.constEnd()) {
+    if (!it->isNumber())
+      return falseString;
+    ++it;
   }
-  if (property == QStringLiteral("strip")) {
-    return object.get().trimmed();
+  return trueString;
+}
+
+static QVariant isLower(const Grantlee::SafeString &object)
+{
+  const QString s = object.get().toLower();
+  return (s == object.get()) ? trueString : falseString;
+}
+
+static QVariant isSpace(const Grantlee::SafeString &object)
+{
+  const QString s = object.get().trimmed();
+  return (s.isEmpty()) ? trueString : falseString;
+}
+
+static QVariant isTitle(const Grantlee::SafeString &object)
+{
+  const QString &s = object.get();
+
+  static const auto titleRe = getIsTitleRE();
+  return (titleRe.match(s).hasMatch()) ? falseString : trueString;
+}
+
+static QVariant isUpper(const Grantlee::SafeString &object)
+{
+  const QString s = object.get().toUpper();
+  return (s == object) ? trueString : falseString;
+}
+
+static QVariant lower(const Grantlee::SafeString &object)
+{
+  return object.get().toLower();
+}
+
+static QVariant splitLines(const Grantlee::SafeString &object)
+{
+  const auto strings = object.get().split(QLatin1Char('\n'));
+  QVariantList list;
+  auto it = strings.constBegin();
+  const auto end = strings.constEnd();
+  for (; it != end; ++it)
+    list << *it;
+  return list;
+}
+
+static QVariant strip(const Grantlee::SafeString &object)
+{
+  return object.get().trimmed();
+}
+
+static QVariant swapCase(const Grantlee::SafeString &object)
+{
+  const QString &inputString = object.get();
+  QString s;
+  s.reserve(inputString.size());
+  auto it = inputString.constBegin();
+  while (it != inputString.constEnd()) {
+    if (it->isUpper())
+      s += it->toLower();
+    else if (it->isLower())
+      s += it->toUpper();
+    else
+      s += *it;
+    ++it;
   }
-  if (property == QStringLiteral("swapcase")) {
-    const QString &inputString = object.get();
-    QString s;
-    s.reserve(inputString.size());
-    auto it = inputString.constBegin();
-    while (it != inputString.constEnd()) {
-      if (it->isUpper())
-        s += it->toLower();
-      else if (it->isLower())
-        s += it->toUpper();
-      else
-        s += *it;
-      ++it;
+  return s;
+}
+
+static QVariant title(const Grantlee::SafeString &object)
+{
+  static const auto titleRe = getTitleRE();
+
+  const QString &s = object.get();
+  QString output;
+  output.reserve(s.size());
+  auto pos = 0;
+  auto nextPos = 0;
+  int matchedLength;
+
+  auto it = titleRe.globalMatch(s);
+  while (it.hasNext()) {
+    auto match = it.next();
+    pos = match.capturedStart();
+    output += match.captured().toUpper();
+    matchedLength = match.capturedLength();
+    if (it.hasNext()) {
+      match = it.peekNext();
+      nextPos = match.capturedStart();
+      output += s.mid(pos + matchedLength, nextPos - pos - 1);
+    } else {
+      output += s.right(s.length() - (pos + matchedLength));
     }
-    return s;
   }
-  if (property == QStringLiteral("title")) {
-    static const auto titleRe = getTitleRE();
-
-    const QString &s = object.get();
-    QString output;
-    output.reserve(s.size());
-    auto pos = 0;
-    auto nextPos = 0;
-    int matchedLength;
-
-    auto it = titleRe.globalMatch(s);
-    while (it.hasNext()) {
-      auto match = it.next();
-      pos = match.capturedStart();
-      output += match.captured().toUpper();
-      matchedLength = match.capturedLength();
-      if (it.hasNext()) {
-        match = it.peekNext();
-        nextPos = match.capturedStart();
-        output += s.mid(pos + matchedLength, nextPos - pos - 1);
-      } else {
-        output += s.right(s.length() - (pos + matchedLength));
-      }
-    }
 
-    return output;
-  }
-  if (property == QStringLiteral("upper")) {
-    return object.get().toUpper();
-  }
-  return {};
+  return output;
+}
+
+static QVariant upper(const Grantlee::SafeString &object)
+{
+  return object.get().toUpper();
+}
+
+template <>
+QVariant
+TypeAccessor<Grantlee::SafeString &>::lookUp(const Grantlee::SafeString &object,
+                                             const QString &property)
+{
+  static const LookupTable<Grantlee::SafeString> table{
+      {"capitalize", capitalize}, {"isalnum", isAlnum},
+      {"isalpha", isAlpha},       {"isdigit", isDigit},
+      {"islower", isLower},       {"isspace", isSpace},
+      {"istitle", isTitle},       {"isupper", isUpper},
+      {"lower", lower},           {"splitlines", splitLines},
+      {"strip", strip},           {"swapcase", swapCase},
+      {"title", title},           {"upper", upper},
+  };
+  return table.lookUp(object, property);
 }
 
 template <>
@@ -200,4 +238,68 @@ TypeAccessor<MetaEnumVariable &>::lookUp(const MetaEnumVariable &object,
 
   return {};
 }
+
+template <>
+QVariant TypeAccessor<QModelIndex &>::lookUp(const QModelIndex &object,
+                                             const QString &property)
+{
+  if (!object.isValid())
+    return {};
+
+  // The data of the index is looked up by role name, as in QML delegates.
+  const auto roleName = property.toUtf8();
+  const auto roleNames = object.model()->roleNames();
+  for (auto it = roleNames.constBegin(); it != roleNames.constEnd(); ++it) {
+    if (it.value() == roleName)
+      return object.data(it.key());
+  }
+
+  if (property == QStringLiteral("row"))
+    return object.row();
+  if (property == QStringLiteral("column"))
+    return object.column();
+  if (property == QStringLiteral("parent")) {
+    const auto parent = object.parent();
+    if (!parent.isValid())
+      return {};
+    return QVariant::fromValue(parent);
+  }
+  if (property == QStringLiteral("children")) {
+    // Fetching more children changes the model.
+    return QVariant::fromValue(
+        ModelRows(const_cast<QAbstractItemModel *>(object.model()), object));
+  }
+
+  auto ok = false;
+  const auto column = property.toInt(&ok);
+  if (ok) {
+    const auto sibling = object.sibling(object.row(), column);
+    if (!sibling.isValid())
+      return {};
+    return QVariant::fromValue(sibling);
+  }
+
+  return {};
+}
+
+template <>
+QVariant TypeAccessor<ModelRows &>::lookUp(const ModelRows &object,
+                                           const QString &property)
+{
+  if (!object.isValid())
+    return {};
+
+  if (property == QStringLiteral("size")
+      || property == QStringLiteral("count"))
+    return object.size();
+  if (property == QStringLiteral("columnCount"))
+    return object.model->columnCount(object.parent);
+
+  auto ok = false;
+  const auto row = property.toInt(&ok);
+  if (ok)
+    return object.at(row);
+
+  return {};
+}
 }
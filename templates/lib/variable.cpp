@@ -28,49 +28,129 @@
 #include "util.h"
 
 #include <QtCore/QMetaEnum>
+#include <QtCore/QSharedData>
 #include <QtCore/QStringList>
 
+#include <new>
+#include <type_traits>
+
 using namespace Grantlee;
 
 namespace Grantlee
 {
 
-class VariablePrivate
+// A VariablePrivate is not changed once its Variable is constructed, so it is
+// shared by all copies of the Variable.
+class VariablePrivate : public QSharedData
 {
 public:
-  VariablePrivate(Variable *variable) : q_ptr(variable), m_localize(false) {}
+  // The new private is referenced by the Variable creating it.
+  VariablePrivate() : m_localize(false), m_constantLookup(false) { ref.ref(); }
 
-  Q_DECLARE_PUBLIC(Variable)
-  Variable *const q_ptr;
+  static VariablePrivate *sharedNull()
+  {
+    // Built in static storage and never destroyed, as its first reference
+    // is never released, so that moving a Variable never allocates.
+    using Storage = std::aligned_storage<sizeof(VariablePrivate),
+                                         alignof(VariablePrivate)>::type;
+    static Storage storage;
+    static auto const null = new (&storage) VariablePrivate;
+    null->ref.ref();
+    return null;
+  }
 
   QString m_varString;
   QVariant m_literal;
   QStringList m_lookups;
   bool m_localize;
+  // Whether m_lookups does not depend on the Context, in which case it is
+  // resolved once into m_constantValue.
+  bool m_constantLookup;
+  QVariant m_constantValue;
 };
 }
 
-Variable::Variable(const Variable &other) : d_ptr(new VariablePrivate(this))
+Variable::Variable(const Variable &other) : d_ptr(other.d_ptr)
 {
-  *this = other;
+  d_ptr->ref.ref();
 }
 
-Variable::Variable() : d_ptr(new VariablePrivate(this)) {}
+Variable::Variable(Variable &&other) noexcept : d_ptr(VariablePrivate::sharedNull())
+{
+  qSwap(d_ptr, other.d_ptr);
+}
 
-Variable::~Variable() { delete d_ptr; }
+Variable::Variable() : d_ptr(VariablePrivate::sharedNull()) {}
+
+Variable::~Variable()
+{
+  if (!d_ptr->ref.deref())
+    delete d_ptr;
+}
 
 Variable &Variable::operator=(const Variable &other)
 {
-  if (&other == this)
-    return *this;
-  d_ptr->m_varString = other.d_ptr->m_varString;
-  d_ptr->m_literal = other.d_ptr->m_literal;
-  d_ptr->m_lookups = other.d_ptr->m_lookups;
-  d_ptr->m_localize = other.d_ptr->m_localize;
+  Variable copy(other);
+  qSwap(d_ptr, copy.d_ptr);
   return *this;
 }
 
-Variable::Variable(const QString &var) : d_ptr(new VariablePrivate(this))
+Variable &Variable::operator=(Variable &&other) noexcept
+{
+  qSwap(d_ptr, other.d_ptr);
+  return *this;
+}
+
+class StaticQtMetaObject : public QObject
+{
+public:
+  static const QMetaObject *_smo()
+  {
+    return
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+        &QObject::staticQtMetaObject;
+#else
+        &Qt::staticMetaObject;
+#endif
+  }
+};
+
+// Resolves a lookup of a Qt enum, such as Qt.AlignRight.key, which does not
+// depend on the Context.
+static QVariant lookUpQtEnum(const QStringList &lookups)
+{
+  if (lookups.size() < 2)
+    return {};
+
+  const auto &enumPart = lookups.at(1);
+
+  static auto globalMetaObject = StaticQtMetaObject::_smo();
+
+  QVariant var;
+  for (auto j = 0; j < globalMetaObject->enumeratorCount() && !var.isValid();
+       ++j) {
+    const auto me = globalMetaObject->enumerator(j);
+
+    if (QLatin1String(me.name()) == enumPart) {
+      var = QVariant::fromValue(MetaEnumVariable(me));
+      break;
+    }
+
+    for (auto k = 0; k < me.keyCount(); ++k) {
+      if (QLatin1String(me.key(k)) == enumPart) {
+        var = QVariant::fromValue(MetaEnumVariable(me, k));
+        break;
+      }
+    }
+  }
+
+  // Enum values have no lazy properties, so the Context is not needed.
+  for (auto i = 2; i < lookups.size() && var.isValid(); ++i)
+    var = MetaType::lookup(var, lookups.at(i));
+  return var;
+}
+
+Variable::Variable(const QString &var) : d_ptr(new VariablePrivate)
 {
   Q_D(Variable);
   d->m_varString = var;
@@ -128,6 +208,10 @@ Variable::Variable(const QString &var) : d_ptr(new VariablePrivate(this))
                       localVar);
       }
       d->m_lookups = localVar.split(QLatin1Char('.'));
+      if (d->m_lookups.first() == QStringLiteral("Qt")) {
+        d->m_constantLookup = true;
+        d->m_constantValue = lookUpQtEnum(d->m_lookups);
+      }
     }
   }
 }
@@ -144,6 +228,12 @@ bool Variable::isConstant() const
   return !d->m_literal.isNull();
 }
 
+bool Variable::isConstantLookup() const
+{
+  Q_D(const Variable);
+  return d->m_constantLookup;
+}
+
 bool Variable::isTrue(Context *c) const { return variantIsTrue(resolve(c)); }
 
 bool Variable::isLocalized() const
@@ -164,73 +254,26 @@ QStringList Variable::lookups() const
   return d->m_lookups;
 }
 
-class StaticQtMetaObject : public QObject
-{
-public:
-  static const QMetaObject *_smo()
-  {
-    return
-#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
-        &QObject::staticQtMetaObject;
-#else
-        &Qt::staticMetaObject;
-#endif
-  }
-};
-
 QVariant Variable::resolve(Context *c) const
 {
   Q_D(const Variable);
   QVariant var;
-  if (!d->m_lookups.isEmpty()) {
+  if (d->m_constantLookup) {
+    var = d->m_constantValue;
+    if (!var.isValid())
+      return {};
+  } else if (!d->m_lookups.isEmpty()) {
     auto i = 0;
-    if (d->m_lookups.at(i) == QStringLiteral("Qt")) {
-      ++i;
-      if (d->m_lookups.size() <= i)
-        return {};
-
-      const auto nextPart = d->m_lookups.at(i);
-      ++i;
-
-      static auto globalMetaObject = StaticQtMetaObject::_smo();
-
-      auto breakout = false;
-      for (auto j = 0; j < globalMetaObject->enumeratorCount(); ++j) {
-        const auto me = globalMetaObject->enumerator(j);
-
-        if (QLatin1String(me.name()) == nextPart) {
-          const MetaEnumVariable mev(me);
-          var = QVariant::fromValue(mev);
-          break;
-        }
-
-        for (auto k = 0; k < me.keyCount(); ++k) {
-          if (QLatin1String(me.key(k)) == nextPart) {
-            const MetaEnumVariable mev(me, k);
-            var = QVariant::fromValue(mev);
-            breakout = true;
-            break;
-          }
-        }
-        if (breakout)
-          break;
-      }
-      if (!var.isValid())
-        return {};
-
-    } else {
-      var = c->lookup(d->m_lookups.at(i++));
-    }
+    c->recordLookupPath(d->m_lookups);
+    var = c->lookup(d->m_lookups.at(i++));
     while (i < d->m_lookups.size()) {
-      var = MetaType::lookup(var, d->m_lookups.at(i++));
+      var = c->resolveLazyValue(MetaType::lookup(var, d->m_lookups.at(i++)));
       if (!var.isValid())
         return {};
     }
   } else {
-    if (isSafeString(d->m_literal))
-      var = QVariant::fromValue(getSafeString(d->m_literal));
-    else
-      var = d->m_literal;
+    // String literals are already stored as a Grantlee::SafeString.
+    var = d->m_literal;
   }
 
   if (d->m_localize) {
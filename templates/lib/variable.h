@@ -47,6 +47,8 @@ class VariablePrivate;
   resolved into the objects they represent in the given Context in the render
   stage.
 
+  Copies of a **%Variable** share what was parsed, so they are cheap to make.
+
   @author Stephen Kelly <steveire@gmail.com>
 */
 class GRANTLEE_TEMPLATES_EXPORT Variable
@@ -67,6 +69,11 @@ public:
   */
   Variable(const Variable &other);
 
+  /**
+    Move constructor
+  */
+  Variable(Variable &&other) noexcept;
+
   /**
     Destructor
   */
@@ -77,6 +84,11 @@ public:
   */
   Variable &operator=(const Variable &other);
 
+  /**
+    Move assignment operator.
+  */
+  Variable &operator=(Variable &&other) noexcept;
+
   /**
     Returns whether this **%Variable** is valid.
   */
@@ -103,6 +115,21 @@ public:
   */
   bool isConstant() const;
 
+  /**
+    Returns whether this **%Variable** is a lookup which does not depend on
+    the Context, such as a Qt enum value. Such a lookup is resolved once when
+    the **%Variable** is created, and resolves to the same value with every
+    Context.
+
+    @code
+      {% if align == Qt.AlignRight %}
+    @endcode
+
+    Unlike @ref isConstant, this does not mean that the value is a literal of
+    the Template.
+  */
+  bool isConstantLookup() const;
+
   /**
     Returns whether this variable is localized, that is, if it is wrapped with
     _(). @see @ref i18n_l10n
@@ -122,7 +149,7 @@ public:
 
 private:
   Q_DECLARE_PRIVATE(Variable)
-  VariablePrivate *const d_ptr;
+  VariablePrivate *d_ptr;
 };
 }
 
@@ -99,7 +99,7 @@ Node *BlockNodeFactory::getNode(const Grantlee::Token &tag, Parser *p) const
 }
 
 BlockNode::BlockNode(const Grantlee::Token &token, const QString &name, QObject *parent)
-    : Node(token, parent), m_name(name), m_stream(nullptr)
+    : Node(token, parent), m_name(name), m_context(nullptr), m_stream(nullptr)
 {
   qRegisterMetaType<Grantlee::SafeString>("Grantlee::SafeString");
 }
@@ -110,49 +110,41 @@ void BlockNode::setNodeList(const NodeList &list) const { m_list = list; }
 
 void BlockNode::render(OutputStream *stream, Context *c) const
 {
-  QVariant &variant = c->renderContext()->data(BLOCK_CONTEXT_KEY);
-  auto blockContext = variant.value<BlockContext>();
+  auto blockContext
+      = c->renderContext()->data(BLOCK_CONTEXT_KEY).value<BlockContext>();
 
   c->push();
 
-  if (blockContext.isEmpty()) {
-    m_context = c;
-    m_stream = stream;
-    c->insert(QStringLiteral("block"),
-              QVariant::fromValue(
-                  const_cast<QObject *>(static_cast<const QObject *>(this))));
-    m_list.render(stream, c);
-    m_stream = nullptr;
-  } else {
-    auto block = static_cast<const BlockNode *>(blockContext.pop(m_name));
-    variant.setValue(blockContext);
-    auto push = block;
-    if (!block)
-      block = this;
-
-    const auto list = block->m_list;
-
-    block = new BlockNode(block->token(), block->m_name, nullptr);
-    block->setNodeList(list);
-    block->m_context = c;
-    block->m_stream = stream;
-    c->insert(QStringLiteral("block"),
-              QVariant::fromValue(
-                  const_cast<QObject *>(static_cast<const QObject *>(block))));
-    list.render(stream, c);
-
-    delete block;
-    if (push) {
-      blockContext.push(m_name, push);
-      variant.setValue(blockContext);
-    }
+  const BlockNode *push = nullptr;
+  auto block = this;
+  if (!blockContext.isEmpty()) {
+    push = static_cast<const BlockNode *>(blockContext.pop(m_name));
+    c->renderContext()->data(BLOCK_CONTEXT_KEY).setValue(blockContext);
+    if (push)
+      block = push;
+  }
+
+  // The node is shared by all renders of the template, which may run on
+  // several threads, so block.super is resolved by a copy holding the
+  // Context and stream of this render.
+  BlockNode renderedBlock(block->token(), block->m_name);
+  renderedBlock.m_list = block->m_list;
+  renderedBlock.m_context = c;
+  renderedBlock.m_stream = stream;
+  c->insert(QStringLiteral("block"),
+            QVariant::fromValue(static_cast<QObject *>(&renderedBlock)));
+  renderedBlock.m_list.render(stream, c);
+
+  if (push) {
+    blockContext.push(m_name, push);
+    c->renderContext()->data(BLOCK_CONTEXT_KEY).setValue(blockContext);
   }
   c->pop();
 }
 
 SafeString BlockNode::getSuper() const
 {
-  if (m_context->renderContext()->contains(BLOCK_CONTEXT_KEY)) {
+  if (m_context && m_context->renderContext()->contains(BLOCK_CONTEXT_KEY)) {
     QVariant &variant = m_context->renderContext()->data(BLOCK_CONTEXT_KEY);
     const auto blockContext = variant.value<BlockContext>();
     auto block = blockContext.getBlock(m_name);
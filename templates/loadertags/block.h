@@ -70,8 +70,9 @@ public:
 private:
   const QString m_name;
   mutable NodeList m_list;
-  mutable Context *m_context;
-  mutable OutputStream *m_stream;
+  // Only set on the copy made for each render.
+  Context *m_context;
+  OutputStream *m_stream;
 };
 
 #endif
@@ -0,0 +1,128 @@
+/*
+  This file is part of the Grantlee template system.
+
+  Copyright (c) 2026 agent <agent@local>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either version
+  2.1 of the Licence, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "cache.h"
+
+#include "engine.h"
+#include "exception.h"
+#include "fragmentcache.h"
+#include "parser.h"
+#include "template.h"
+#include "util.h"
+
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QUrl>
+
+CacheNodeFactory::CacheNodeFactory() = default;
+
+Node *CacheNodeFactory::getNode(const Grantlee::Token &tag, Parser *p) const
+{
+  auto expr = smartSplit(tag.content);
+
+  if (expr.size() < 3)
+    throw Grantlee::Exception(
+        TagSyntaxError,
+        QStringLiteral("Error: cache tag takes at least two arguments"),
+        tag.linenumber, tag.columnnumber, tag.content);
+
+  expr.takeAt(0);
+  const FilterExpression timeout(expr.takeAt(0), p);
+  const auto fragmentName = expr.takeAt(0);
+
+  auto n = new CacheNode(tag, timeout, fragmentName,
+                         getFilterExpressionList(expr, p), p);
+  auto list = p->parse(n, QStringLiteral("endcache"), tag);
+  n->setList(list);
+  p->removeNextToken();
+  return n;
+}
+
+CacheNode::CacheNode(const Grantlee::Token &token,
+                     const FilterExpression &timeout,
+                     const QString &fragmentName,
+                     const QList<FilterExpression> &varyOn, QObject *parent)
+    : Node(token, parent), m_timeout(timeout), m_fragmentName(fragmentName),
+      m_varyOn(varyOn)
+{
+}
+
+void CacheNode::setList(const NodeList &nodeList) { m_nodeList = nodeList; }
+
+QString CacheNode::cacheKey(Context *c) const
+{
+  // Like Django, the fragment name is kept readable and the values it varies
+  // on are hashed.
+  QByteArray varyOn;
+  for (const auto &fe : m_varyOn) {
+    if (!varyOn.isEmpty())
+      varyOn.append(':');
+    varyOn.append(
+        QUrl::toPercentEncoding(getSafeString(fe.resolve(c)).get()));
+  }
+  return QStringLiteral("grantlee.cache.") + m_fragmentName
+         + QLatin1Char('.')
+         + QString::fromLatin1(
+               QCryptographicHash::hash(varyOn, QCryptographicHash::Md5)
+                   .toHex());
+}
+
+void CacheNode::render(OutputStream *stream, Context *c) const
+{
+  const auto cache = containerTemplate()->engine()->fragmentCache();
+  if (!cache) {
+    m_nodeList.render(stream, c);
+    return;
+  }
+
+  const auto timeoutVariant = m_timeout.resolve(c);
+  auto ok = true;
+  int timeout;
+  if (timeoutVariant.userType() == qMetaTypeId<int>())
+    timeout = timeoutVariant.value<int>();
+  else
+    timeout = getSafeString(timeoutVariant).get().toInt(&ok);
+  if (!ok)
+    throw Grantlee::Exception(
+        TagSyntaxError,
+        QStringLiteral("Error: cache tag got a non-integer timeout value"),
+        -1, -1, QString());
+
+  // A fragment which would not be stored is not looked up either.
+  if (timeout == 0) {
+    m_nodeList.render(stream, c);
+    return;
+  }
+
+  const auto key = cacheKey(c);
+
+  QString output;
+  if (cache->lookup(key, &output)) {
+    (*stream) << output;
+    return;
+  }
+
+  QTextStream textStream(&output);
+  auto temp = stream->clone(&textStream);
+  m_nodeList.render(temp.data(), c);
+  textStream.flush();
+
+  cache->insert(key, output, timeout);
+  (*stream) << output;
+}
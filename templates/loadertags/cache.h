@@ -0,0 +1,63 @@
+/*
+  This file is part of the Grantlee template system.
+
+  Copyright (c) 2026 agent <agent@local>
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either version
+  2.1 of the Licence, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef CACHENODE_H
+#define CACHENODE_H
+
+#include "node.h"
+
+namespace Grantlee
+{
+class Parser;
+}
+
+using namespace Grantlee;
+
+class CacheNodeFactory : public AbstractNodeFactory
+{
+  Q_OBJECT
+public:
+  CacheNodeFactory();
+
+  Node *getNode(const Grantlee::Token &tag, Parser *p) const override;
+};
+
+class CacheNode : public Node
+{
+  Q_OBJECT
+public:
+  CacheNode(const Grantlee::Token &token, const FilterExpression &timeout,
+            const QString &fragmentName, const QList<FilterExpression> &varyOn,
+            QObject *parent = {});
+
+  void setList(const NodeList &nodeList);
+
+  void render(OutputStream *stream, Context *c) const override;
+
+private:
+  QString cacheKey(Context *c) const;
+
+  FilterExpression m_timeout;
+  QString m_fragmentName;
+  QList<FilterExpression> m_varyOn;
+  NodeList m_nodeList;
+};
+
+#endif
@@ -25,6 +25,7 @@
 #include "taglibraryinterface.h"
 
 #include "block.h"
+#include "cache.h"
 #include "extends.h"
 #include "include.h"
 
@@ -50,6 +51,7 @@ public:
 
     QHash<QString, AbstractNodeFactory *> nodeFactories;
     nodeFactories.insert(QStringLiteral("block"), new BlockNodeFactory());
+    nodeFactories.insert(QStringLiteral("cache"), new CacheNodeFactory());
     nodeFactories.insert(QStringLiteral("extends"), new ExtendsNodeFactory());
     nodeFactories.insert(QStringLiteral("include"), new IncludeNodeFactory());
     return nodeFactories;
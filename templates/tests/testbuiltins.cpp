@@ -23,14 +23,23 @@
 
 #include <QtCore/QDebug>
 #include <QtCore/QFileInfo>
+#include <QtCore/QPointer>
+#include <QtCore/QThreadPool>
 #include <QtTest/QTest>
 
+#include <algorithm>
+#include <utility>
+
 #include "cachingloaderdecorator.h"
 #include "context.h"
 #include "coverageobject.h"
 #include "engine.h"
+#include "filter.h"
 #include "filterexpression.h"
 #include "grantlee_paths.h"
+#include "node.h"
+#include "parser.h"
+#include "taglibraryinterface.h"
 #include "template.h"
 #include "util.h"
 #include <metaenumvariable_p.h>
@@ -187,6 +196,78 @@ public:
   }
 };
 
+class ReverseFilter : public Filter
+{
+public:
+  QVariant doFilter(const QVariant &input, const QVariant &argument = {},
+                    bool autoescape = {}) const override
+  {
+    Q_UNUSED(argument)
+    Q_UNUSED(autoescape)
+    auto s = getSafeString(input).get();
+    std::reverse(s.begin(), s.end());
+    return s;
+  }
+};
+
+class StaticFilterLibrary : public QObject, public TagLibraryInterface
+{
+  Q_OBJECT
+  Q_INTERFACES(Grantlee::TagLibraryInterface)
+public:
+  StaticFilterLibrary(QObject *parent = {}) : QObject(parent) {}
+
+  QHash<QString, Filter *> filters(const QString &name = {}) override
+  {
+    Q_UNUSED(name);
+    QHash<QString, Filter *> filters;
+    filters.insert(QStringLiteral("reverse"), new ReverseFilter());
+    return filters;
+  }
+};
+
+class TemplateNameNode : public Node
+{
+public:
+  TemplateNameNode(const Grantlee::Token &token, QObject *parent = {})
+      : Node(token, parent)
+  {
+  }
+
+  void render(OutputStream *stream, Context *c) const override
+  {
+    Q_UNUSED(c)
+    (*stream) << containerTemplate()->objectName();
+  }
+};
+
+class TemplateNameNodeFactory : public AbstractNodeFactory
+{
+public:
+  Node *getNode(const Grantlee::Token &tag, Parser *p) const override
+  {
+    return new TemplateNameNode(tag, p);
+  }
+};
+
+class StaticTagLibrary : public QObject, public TagLibraryInterface
+{
+  Q_OBJECT
+  Q_INTERFACES(Grantlee::TagLibraryInterface)
+public:
+  StaticTagLibrary(QObject *parent = {}) : QObject(parent) {}
+
+  QHash<QString, AbstractNodeFactory *>
+  nodeFactories(const QString &name = {}) override
+  {
+    Q_UNUSED(name);
+    QHash<QString, AbstractNodeFactory *> factories;
+    factories.insert(QStringLiteral("template_name"),
+                     new TemplateNameNodeFactory());
+    return factories;
+  }
+};
+
 class TestBuiltinSyntax : public CoverageObject
 {
   Q_OBJECT
@@ -201,6 +282,16 @@ private Q_SLOTS:
 
   void testRenderAfterError();
 
+  void testStaticLibrary();
+
+  void testSetContentAgain();
+
+  void testRenderBatch();
+
+  void testLazyValues();
+
+  void testIncrementalRender();
+
   void testBasicSyntax_data();
   void testBasicSyntax() { doTest(); }
 
@@ -288,6 +379,46 @@ void TestBuiltinSyntax::testObjects()
   QVERIFY(!v1.isTrue(&c1));
   QVERIFY(!v1.isLocalized());
 
+  const Variable qtEnum(QStringLiteral("Qt.AlignRight.key"));
+  Variable qtEnumCopy;
+  qtEnumCopy = qtEnum;
+  QVERIFY(qtEnumCopy.isConstantLookup());
+  QVERIFY(!qtEnumCopy.isConstant());
+  QCOMPARE(qtEnumCopy.resolve(&c1).value<QString>(),
+           QStringLiteral("AlignRight"));
+  QVERIFY(!Variable(QStringLiteral("var.Qt")).isConstantLookup());
+
+  Variable v4(QStringLiteral("var.name"));
+  Variable v5(std::move(v4));
+  QVERIFY(!v4.isValid());
+  QCOMPARE(v5.lookups(),
+           QStringList({QStringLiteral("var"), QStringLiteral("name")}));
+  v4 = v5;
+  v5 = Variable();
+  QVERIFY(!v5.isValid());
+  QCOMPARE(v4.lookups().size(), 2);
+
+  QVariantHash var;
+  var.insert(QStringLiteral("name"), QStringLiteral("Alice"));
+  c1.insert(QStringLiteral("var"), var);
+  auto resolved = [](const QVariant &value) -> QString {
+    return getSafeString(value).get();
+  };
+  QCOMPARE(resolved(v4.resolve(&c1)), QStringLiteral("Alice"));
+
+  FilterExpression f4(QStringLiteral("var.name"), nullptr);
+  FilterExpression f5(std::move(f4));
+  QVERIFY(!f4.isValid());
+  QCOMPARE(resolved(f5.resolve(&c1)), QStringLiteral("Alice"));
+  f4 = std::move(f5);
+  QCOMPARE(resolved(f4.resolve(&c1)), QStringLiteral("Alice"));
+  QCOMPARE(f4.variable().lookups(),
+           QStringList({QStringLiteral("var"), QStringLiteral("name")}));
+  f5 = f4;
+  f4 = FilterExpression();
+  QVERIFY(!f4.isValid());
+  QCOMPARE(resolved(f5.resolve(&c1)), QStringLiteral("Alice"));
+
   c1.setMutating(true);
   QVERIFY(c1.isMutating());
 
@@ -430,6 +561,234 @@ void TestBuiltinSyntax::testRenderAfterError()
   QCOMPARE(t->error(), NoError);
 }
 
+void TestBuiltinSyntax::testSetContentAgain()
+{
+  StaticTagLibrary library;
+
+  Engine engine;
+  engine.setPluginPaths({QStringLiteral(GRANTLEE_PLUGIN_PATH)});
+  engine.addStaticLibrary(QStringLiteral("static_tags"), &library);
+
+  auto t = engine.newTemplate(
+      QStringLiteral("{% load static_tags %}{% if true %}{% template_name "
+                     "%}{% endif %}{{ var }}"),
+      QStringLiteral("first"));
+  QCOMPARE(t->error(), NoError);
+  const auto nodeCount = t->findChildren<Node *>().size();
+
+  // A node created after compiling is allocated on the heap, and finds its
+  // Template through its parent.
+  auto heapNode = new TemplateNameNode({}, t.data());
+  QString output;
+  QTextStream textStream(&output);
+  OutputStream stream(&textStream);
+  Context c;
+  heapNode->render(&stream, &c);
+  textStream.flush();
+  QCOMPARE(output, QStringLiteral("first"));
+
+  c.insert(QStringLiteral("var"), QStringLiteral("!"));
+  QCOMPARE(t->render(&c), QStringLiteral("first!"));
+
+  // Replacing the content destroys the previous nodes, whether they were
+  // compiled or not.
+  QPointer<Node> heapNodeGuard(heapNode);
+  for (auto i = 0; i < 3; ++i) {
+    t->setObjectName(QStringLiteral("again"));
+    t->setContent(QStringLiteral("{% load static_tags %}{% if true %}{% "
+                                 "template_name %}{% endif %}{{ var }}"));
+    QCOMPARE(t->error(), NoError);
+    QCOMPARE(t->render(&c), QStringLiteral("again!"));
+    QCOMPARE(t->findChildren<Node *>().size(), nodeCount);
+  }
+  QVERIFY(heapNodeGuard.isNull());
+
+  // Content which does not compile leaves the previous content in place.
+  t->setContent(QStringLiteral("{% load static_tags %}{% if %}"));
+  QCOMPARE(t->error(), TagSyntaxError);
+  QCOMPARE(t->findChildren<Node *>().size(), nodeCount);
+  QCOMPARE(t->render(&c), QStringLiteral("again!"));
+}
+
+void TestBuiltinSyntax::testStaticLibrary()
+{
+  StaticFilterLibrary library;
+
+  Engine engine;
+  engine.setPluginPaths({QStringLiteral(GRANTLEE_PLUGIN_PATH)});
+  engine.addStaticLibrary(QStringLiteral("static_filters"), &library);
+
+  auto t = engine.newTemplate(
+      QStringLiteral("{% load static_filters %}{{ var|reverse }}"),
+      QStringLiteral("static"));
+  QCOMPARE(t->error(), NoError);
+
+  Context c;
+  c.insert(QStringLiteral("var"), QStringLiteral("abc"));
+  QCOMPARE(t->render(&c), QStringLiteral("cba"));
+}
+
+void TestBuiltinSyntax::testRenderBatch()
+{
+  Engine engine;
+  engine.setPluginPaths({QStringLiteral(GRANTLEE_PLUGIN_PATH)});
+
+  auto t = engine.newTemplate(
+      QStringLiteral("{% for item in items %}{% ifchanged %}{{ item }}"
+                     "{% endifchanged %}{% endfor %}-{{ name|upper }}"),
+      QStringLiteral("batch"));
+  QCOMPARE(t->error(), NoError);
+
+  QThreadPool pool;
+  pool.setMaxThreadCount(4);
+
+  QList<Context *> contexts;
+  QStringList expected;
+  for (auto i = 0; i < 200; ++i) {
+    auto c = new Context;
+    const auto name = QStringLiteral("name%1").arg(i);
+    c->insert(QStringLiteral("name"), name);
+    c->insert(QStringLiteral("items"), QVariantList{i, i, i + 1});
+    contexts.append(c);
+    expected.append(QString::number(i) + QString::number(i + 1)
+                    + QLatin1Char('-') + name.toUpper());
+  }
+
+  QCOMPARE(t->renderBatch(contexts, &pool), expected);
+  QCOMPARE(t->error(), NoError);
+
+  QVector<QString> outputs(contexts.size());
+  QList<QTextStream *> textStreams;
+  QList<OutputStream *> streams;
+  for (auto i = 0; i < contexts.size(); ++i) {
+    textStreams.append(new QTextStream(&outputs[i]));
+    streams.append(new OutputStream(textStreams.last()));
+  }
+  t->renderBatch(streams, contexts, &pool);
+  qDeleteAll(streams);
+  qDeleteAll(textStreams);
+  QCOMPARE(outputs.toList(), expected);
+
+  qDeleteAll(contexts);
+}
+
+void TestBuiltinSyntax::testLazyValues()
+{
+  Engine engine;
+  engine.setPluginPaths({QStringLiteral(GRANTLEE_PLUGIN_PATH)});
+
+  auto t = engine.newTemplate(
+      QStringLiteral("{% if show %}{{ used }}{{ used }}{{ obj.nested }}"
+                     "{% else %}{{ unused }}{% endif %}"),
+      QStringLiteral("lazy"));
+  QCOMPARE(t->error(), NoError);
+
+  auto usedCalls = 0;
+  auto unusedCalls = 0;
+  auto nestedCalls = 0;
+
+  Context c;
+  c.insert(QStringLiteral("show"), true);
+  c.insertLazy(QStringLiteral("used"), [&usedCalls] {
+    ++usedCalls;
+    return QVariant(QStringLiteral("a<b"));
+  });
+  c.insertLazy(QStringLiteral("unused"), [&unusedCalls] {
+    ++unusedCalls;
+    return QVariant(QStringLiteral("unused"));
+  });
+  QVariantHash obj;
+  obj.insert(QStringLiteral("nested"), Context::lazyValue([&nestedCalls] {
+               ++nestedCalls;
+               return QVariant(42);
+             }));
+  c.insert(QStringLiteral("obj"), obj);
+
+  QCOMPARE(t->render(&c), QStringLiteral("a&lt;ba&lt;b42"));
+  QCOMPARE(usedCalls, 1);
+  QCOMPARE(unusedCalls, 0);
+  QCOMPARE(nestedCalls, 1);
+  QCOMPARE(c.untouchedLazyValues(), QStringList{QStringLiteral("unused")});
+
+  // Lazy values are computed again in each render.
+  QCOMPARE(t->render(&c), QStringLiteral("a&lt;ba&lt;b42"));
+  QCOMPARE(usedCalls, 2);
+}
+
+void TestBuiltinSyntax::testIncrementalRender()
+{
+  Engine engine;
+  engine.setPluginPaths({QStringLiteral(GRANTLEE_PLUGIN_PATH)});
+
+  auto t = engine.newTemplate(
+      QStringLiteral("<h1>{{ title }}</h1>{% for item in items %}{{ item }}"
+                     "{% endfor %}<p>{{ user.name }}</p>"),
+      QStringLiteral("incremental"));
+  QCOMPARE(t->error(), NoError);
+
+  QVariantHash user;
+  user.insert(QStringLiteral("name"), QStringLiteral("Alice"));
+
+  Context c;
+  c.insert(QStringLiteral("title"), QStringLiteral("Title"));
+  c.insert(QStringLiteral("items"), QVariantList{1, 2});
+  c.insert(QStringLiteral("user"), user);
+
+  RenderedSections sections;
+  QCOMPARE(t->renderTracked(&c, &sections),
+           QStringLiteral("<h1>Title</h1>12<p>Alice</p>"));
+  QCOMPARE(t->error(), NoError);
+  QCOMPARE(sections.size(), 7);
+  QVERIFY(sections.at(1).dependencies.contains(QStringLiteral("title")));
+  QVERIFY(sections.at(3).dependencies.contains(QStringLiteral("items")));
+  QVERIFY(sections.at(5).dependencies.contains(QStringLiteral("user.name")));
+  QVERIFY(sections.at(0).dependencies.isEmpty());
+
+  // Only the sections depending on the changed keys are rendered again.
+  c.insert(QStringLiteral("title"), QStringLiteral("New title"));
+  c.insert(QStringLiteral("items"), QVariantList{3});
+  QCOMPARE(t->rerender(&c, {QStringLiteral("title")}, &sections),
+           QStringLiteral("<h1>New title</h1>12<p>Alice</p>"));
+
+  user.insert(QStringLiteral("name"), QStringLiteral("Bob"));
+  c.insert(QStringLiteral("user"), user);
+  QCOMPARE(t->rerender(&c, {QStringLiteral("user"), QStringLiteral("items")},
+                       &sections),
+           QStringLiteral("<h1>New title</h1>3<p>Bob</p>"));
+
+  // Sections using names inserted by an earlier section are rendered again
+  // when it is.
+  t = engine.newTemplate(
+      QStringLiteral("{% regroup people by g as groups %}{% for group in "
+                     "groups %}{{ group.grouper }}:{% for p in group.list %}{{ "
+                     "p.n }}{% endfor %};{% endfor %}"),
+      QStringLiteral("incremental-insertions"));
+  QCOMPARE(t->error(), NoError);
+
+  auto person = [](const QString &g, const QString &n) {
+    QVariantHash hash;
+    hash.insert(QStringLiteral("g"), g);
+    hash.insert(QStringLiteral("n"), n);
+    return hash;
+  };
+
+  c.insert(QStringLiteral("people"),
+           QVariantList{person(QStringLiteral("x"), QStringLiteral("1")),
+                        person(QStringLiteral("x"), QStringLiteral("2")),
+                        person(QStringLiteral("y"), QStringLiteral("3"))});
+  QCOMPARE(t->renderTracked(&c, &sections), QStringLiteral("x:12;y:3;"));
+  QCOMPARE(sections.size(), 2);
+  QCOMPARE(sections.at(0).insertions,
+           QSet<QString>{QStringLiteral("groups")});
+  QVERIFY(sections.at(1).insertions.isEmpty());
+  QVERIFY(!sections.at(1).dependencies.contains(QStringLiteral("people")));
+
+  c.insert(QStringLiteral("people"),
+           QVariantList{person(QStringLiteral("z"), QStringLiteral("4"))});
+  QCOMPARE(t->rerender(&c, {QStringLiteral("people")}, &sections),
+           QStringLiteral("z:4;"));
+}
+
 void TestBuiltinSyntax::initTestCase()
 {
   m_engine = getEngine();
@@ -940,6 +1299,10 @@ void TestBuiltinSyntax::testEnums_data()
                               << QString() << NoError;
   QTest::newRow("qt-enums08")
       << QStringLiteral("{{ Qt }}") << dict << QString() << NoError;
+  QTest::newRow("qt-enums09")
+      << QStringLiteral(
+             "{% if Qt.AlignRight == 2 %}{{ Qt.AlignRight.key }}{% endif %}")
+      << dict << QStringLiteral("AlignRight") << NoError;
 
   dict.clear();
 
@@ -1498,6 +1861,30 @@ void TestBuiltinSyntax::testAlternativeEscaping()
   jsOutput = jsOutput + QLatin1String(" ") + jsOutput;
 
   QCOMPARE(output, jsOutput);
+
+  // A filter writing to the stream escapes the same way as when it is not the
+  // last filter. The input has no letters, so lower changes nothing.
+  auto t2 = engine1->newTemplate(
+      QStringLiteral("{{ var|force_escape }}|{{ var|force_escape|lower }}|{{ "
+                     "var|escape }}|{{ var|escape|lower }}|{{ var|linebreaksbr "
+                     "}}|{{ var|linebreaksbr|lower }}"),
+      QStringLiteral("\"template2\""));
+
+  const QList<OutputStream *> streams{&noEscapeOs, &jsOs};
+  for (auto stream : streams) {
+    output.clear();
+    t2->render(stream, &c);
+    const auto parts = output.split(QLatin1Char('|'));
+    QCOMPARE(parts.size(), 6);
+    QCOMPARE(parts.at(0),
+             QStringLiteral("&lt; &gt; \r\n &amp; &quot; &#39; # = % $"));
+    QCOMPARE(parts.at(1), parts.at(0));
+    QCOMPARE(parts.at(3), parts.at(2));
+    QCOMPARE(parts.at(5), parts.at(4));
+  }
+  output.clear();
+  t2->render(&noEscapeOs, &c);
+  QVERIFY(output.contains(input + QLatin1Char('|')));
 }
 
 void TestBuiltinSyntax::testTemplatePathSafety_data()
@@ -22,6 +22,7 @@
 #define DEFAULTTAGSTEST_H
 
 #include <QtCore/QDebug>
+#include <QtCore/qnumeric.h>
 #include <QtTest/QTest>
 
 #include "context.h"
@@ -124,6 +125,7 @@ private Q_SLOTS:
 
   void testIfChangedTag_data();
   void testIfChangedTag() { doTest(); }
+  void benchmarkIfChangedTag();
 
   void testAutoescapeTag_data();
   void testAutoescapeTag() { doTest(); }
@@ -1106,6 +1108,21 @@ void TestDefaultTags::testIfTag_data()
                                    << dict << QStringLiteral("no") << NoError;
 }
 
+static QVariant forwardIterable(const QVariantList &items, int size = -1)
+{
+  return Context::forwardIterable(
+      [items] {
+        auto position = 0;
+        return [items, position](QVariant &item) mutable {
+          if (position == items.size())
+            return false;
+          item = items.at(position++);
+          return true;
+        };
+      },
+      size);
+}
+
 void TestDefaultTags::testForTag_data()
 {
   QTest::addColumn<QString>("input");
@@ -1311,6 +1328,46 @@ void TestDefaultTags::testForTag_data()
       << QStringLiteral("{% for val in values %}{{ val }}{% empty %}values "
                         "array not found{% endfor %}")
       << dict << QStringLiteral("values array not found") << NoError;
+
+  // Forward iterables:
+
+  dict.clear();
+  dict.insert(QStringLiteral("values"), forwardIterable({1, 2, 3}));
+  QTest::newRow("for-tag-forward01")
+      << QStringLiteral("{% for val in values %}{{ forloop.counter }}:{{ val "
+                        "}}:{{ forloop.revcounter }}{% if forloop.first %}<{% "
+                        "endif %}{% if forloop.last %}>{% endif %},{% endfor %}")
+      << dict << QStringLiteral("1:1:<,2:2:,3:3:>,") << NoError;
+
+  dict.insert(QStringLiteral("values"), forwardIterable({1, 2, 3}, 3));
+  QTest::newRow("for-tag-forward02")
+      << QStringLiteral("{% for val in values %}{{ val }}:{{ "
+                        "forloop.revcounter }},{% endfor %}")
+      << dict << QStringLiteral("1:3,2:2,3:1,") << NoError;
+
+  // The items are produced again for each loop.
+  QTest::newRow("for-tag-forward03")
+      << QStringLiteral("{% for val in values reversed %}{{ val }}{% endfor "
+                        "%}{% for val in values %}{{ val }}{% endfor %}")
+      << dict << QStringLiteral("321123") << NoError;
+
+  QTest::newRow("for-tag-forward04")
+      << QStringLiteral("{{ values|length }}{{ values|last }}{% if 2 in values "
+                        "%}yes{% endif %}")
+      << dict << QStringLiteral("33yes") << NoError;
+
+  dict.insert(QStringLiteral("values"),
+              forwardIterable({QVariantList{1, 2}, QVariantList{3, 4}}));
+  QTest::newRow("for-tag-forward05")
+      << QStringLiteral(
+             "{% for a, b in values %}{{ a }}{{ b }},{% endfor %}")
+      << dict << QStringLiteral("12,34,") << NoError;
+
+  dict.insert(QStringLiteral("values"), forwardIterable({}));
+  QTest::newRow("for-tag-forward06")
+      << QStringLiteral(
+             "{% for val in values %}{{ val }}{% empty %}empty{% endfor %}")
+      << dict << QStringLiteral("empty") << NoError;
 }
 
 void TestDefaultTags::testIfEqualTag_data()
@@ -1904,6 +1961,28 @@ void TestDefaultTags::testSpacelessTag_data()
                                << dict
                                << QStringLiteral("<b><i>This & that</i></b>")
                                << NoError;
+
+  // More content than the text stream buffers at once.
+  dict.insert(QStringLiteral("text"),
+              QString::fromUtf8("  <p> \xc3\xa9 </p>\n").repeated(4000));
+  QTest::newRow("spaceless07")
+      << QStringLiteral("{% spaceless %}{{ text|safe }}{% endspaceless %}")
+      << dict << QString::fromUtf8("<p> \xc3\xa9 </p>").repeated(4000)
+      << NoError;
+
+  // Only ASCII whitespace is removed between tags, but any whitespace at
+  // either end.
+  dict.insert(QStringLiteral("text"), QString::fromUtf8("\xc2\xa0"));
+  QTest::newRow("spaceless08")
+      << QStringLiteral("{% spaceless %}<td>{{ text }}</td> <td> {{ text }} "
+                        "</td>{% endspaceless %}")
+      << dict
+      << QString::fromUtf8("<td>\xc2\xa0</td><td> \xc2\xa0 </td>")
+      << NoError;
+  QTest::newRow("spaceless09")
+      << QStringLiteral(
+             "{% spaceless %}{{ text }} <b>x</b> {{ text }}{% endspaceless %}")
+      << dict << QStringLiteral("<b>x</b>") << NoError;
 }
 
 void TestDefaultTags::testRegroupTag_data()
@@ -2038,6 +2117,42 @@ void TestDefaultTags::testRegroupTag_data()
                              "{% endfor %},"
                              "{% endfor %}")
       << dict << QStringLiteral("1:ab,2:a,3:cd,") << NoError;
+
+  dict.clear();
+  list.clear();
+
+  const QStringList titles{QStringLiteral("a"), QStringLiteral("b"),
+                           QStringLiteral("c"), QStringLiteral("d")};
+  const QStringList authors{QStringLiteral("x"), QStringLiteral("x"),
+                            QStringLiteral("y"), QStringLiteral("x")};
+  for (auto i = 0; i < titles.size(); ++i) {
+    hash.clear();
+    hash.insert(QStringLiteral("title"), titles.at(i));
+    hash.insert(QStringLiteral("author"),
+                QVariantHash{{QStringLiteral("name"), authors.at(i)}});
+    list.append(hash);
+  }
+  dict.insert(QStringLiteral("data"), list);
+
+  QTest::newRow("regroup04")
+      << QString::fromLatin1("{% regroup data by author.name as grouped %}"
+                             "{% for group in grouped %}"
+                             "{{ group.grouper }}:"
+                             "{% for item in group.list %}"
+                             "{{ item.title }}"
+                             "{% endfor %},"
+                             "{% endfor %}")
+      << dict << QStringLiteral("x:ab,y:c,x:d,") << NoError;
+
+  QTest::newRow("regroup05")
+      << QString::fromLatin1("{% regroup data by author.missing as grouped %}"
+                             "{% for group in grouped %}"
+                             "{{ group.grouper }}:"
+                             "{% for item in group.list %}"
+                             "{{ item.title }}"
+                             "{% endfor %},"
+                             "{% endfor %}")
+      << dict << QStringLiteral(":abcd,") << NoError;
 }
 
 void TestDefaultTags::testIfChangedTag_data()
@@ -2226,6 +2341,75 @@ void TestDefaultTags::testIfChangedTag_data()
              "endifchanged %}{{ forloop.counter }}{% endfor %}")
       << dict << QStringLiteral("***1*1...2***2*3...4...5***3*6***4*7")
       << NoError;
+
+  // The content is rendered once, so content which depends on
+  // ifchanged.firstloop changes after the first change.
+  dict.clear();
+  dict.insert(QStringLiteral("num"), QVariantList{1, 1, 2, 2, 3});
+  QTest::newRow("ifchanged-firstloop01")
+      << QStringLiteral("{% for n in num %}{% ifchanged %}{% if not "
+                        "ifchanged.firstloop %},{% endif %}{{ n }}{% "
+                        "endifchanged %}{% endfor %}")
+      << dict << QStringLiteral("1,1,2,3") << NoError;
+  QTest::newRow("ifchanged-firstloop02")
+      << QStringLiteral("{% for n in num %}{% ifchanged n %}{% if not "
+                        "ifchanged.firstloop %},{% endif %}{{ n }}{% "
+                        "endifchanged %}{% endfor %}")
+      << dict << QStringLiteral("1,2,3") << NoError;
+
+  // Values which can not be hashed are compared.
+  dict.insert(QStringLiteral("dates"),
+              QVariantList{QDate(2010, 1, 1), QDate(2010, 1, 1),
+                           QDate(2010, 1, 2)});
+  QTest::newRow("ifchanged-param06")
+      << QStringLiteral("{% for d in dates %}{% ifchanged d %}x{% else %}-{% "
+                        "endifchanged %}{% endfor %}")
+      << dict << QStringLiteral("x-x") << NoError;
+
+  // NaN is never equal to the value seen before.
+  dict.insert(QStringLiteral("values"),
+              QVariantList{qQNaN(), qQNaN(), 1.0, 1.0});
+  QTest::newRow("ifchanged-param07")
+      << QStringLiteral("{% for v in values %}{% ifchanged v %}x{% else %}-{% "
+                        "endifchanged %}{% endfor %}")
+      << dict << QStringLiteral("xxx-") << NoError;
+
+  // Without arguments the content is rendered once for each iteration and
+  // written out when it changed.
+  dict.insert(QStringLiteral("num"), QVariantList{1, 2, 3});
+  QTest::newRow("ifchanged-cycle01")
+      << QStringLiteral("{% for n in num %}{% ifchanged %}{% cycle a,a,b %}{% "
+                        "endifchanged %}{% endfor %}")
+      << dict << QStringLiteral("ab") << NoError;
+
+  // Strings are compared by their content, whether they are safe or not, but
+  // a string is not equal to a number with the same text.
+  dict.insert(QStringLiteral("mixed"),
+              QVariantList{QStringLiteral("1"),
+                           QVariant::fromValue(markSafe(QStringLiteral("1"))),
+                           1, 1.0});
+  QTest::newRow("ifchanged-param08")
+      << QStringLiteral("{% for v in mixed %}{% ifchanged v %}x{% else %}-{% "
+                        "endifchanged %}{% endfor %}")
+      << dict << QStringLiteral("x-x-") << NoError;
+}
+
+void TestDefaultTags::benchmarkIfChangedTag()
+{
+  auto t = m_engine->newTemplate(
+      QStringLiteral("{% for row in rows %}{% ifchanged %}<h2>{{ row.0 }}</h2>"
+                     "{% endifchanged %}{% ifchanged row.0 row.1 %}<h3>{{ "
+                     "row.1 }}</h3>{% endifchanged %}{{ row.2 }}{% endfor %}"),
+      QStringLiteral("benchmarkIfChangedTag"));
+  QCOMPARE(t->error(), NoError);
+
+  QVariantList rows;
+  for (auto i = 0; i < 10000; ++i)
+    rows.append(QVariant(QVariantList{i / 100, i / 10, i}));
+  Context c;
+  c.insert(QStringLiteral("rows"), rows);
+
+  QBENCHMARK { t->render(&c); }
 }
 
 void TestDefaultTags::testAutoescapeTag_data()
@@ -2440,6 +2624,19 @@ void TestDefaultTags::testDebugTag_data()
       << QStringLiteral("{% debug %}") << dict
       << QStringLiteral("\n\nContext:\nkey answer, type int\nEnd context:\n\n")
       << NoError;
+  dict.clear();
+  dict.insert(QStringLiteral("name"), QStringLiteral("Alice"));
+  QTest::newRow("debug-tag03")
+      << QStringLiteral("{% debug %}") << dict
+      << QStringLiteral("\n\nContext:\nkey name, type QString\nEnd context:\n\n")
+      << NoError;
+  dict.insert(QStringLiteral("name"),
+              QVariant::fromValue(Grantlee::SafeString(QStringLiteral("Alice"))));
+  QTest::newRow("debug-tag04")
+      << QStringLiteral("{% debug %}") << dict
+      << QStringLiteral(
+             "\n\nContext:\nkey name, type Grantlee::SafeString\nEnd context:\n\n")
+      << NoError;
 }
 
 void TestDefaultTags::testLoadTag_data()
@@ -65,6 +65,10 @@ private Q_SLOTS:
   void testIntegerFilters_data();
   void testIntegerFilters() { doTest(); }
 
+  void benchmarkDateFilter();
+  void benchmarkStringFilters_data();
+  void benchmarkStringFilters();
+
 private:
   void doTest();
 
@@ -378,12 +382,80 @@ void TestFilters::testDateBasedFilters_data()
                           << d.toString(QStringLiteral("MMM. d, yyyy"))
                           << NoError;
 
+  const QDateTime dt(QDate(2009, 11, 5), QTime(7, 8, 9, 45));
+  dict.clear();
+  dict.insert(QStringLiteral("d"), dt);
+
+  const auto format = QStringLiteral("ddd dddd d dd M MM MMM MMMM yy yyyy");
+  QTest::newRow("date04") << QStringLiteral("{{ d|date:\"%1\" }}").arg(format)
+                          << dict << dt.toString(format) << NoError;
+  QTest::newRow("date05") << "{{ d|date:\"yyyy-MM-ddThh:mm:ss.zzz\" }}"
+                          << dict
+                          << QStringLiteral("2009-11-05T07:08:09.045")
+                          << NoError;
+  QTest::newRow("date06") << "{{ d|date:\"h:m:s ap\" }}" << dict
+                          << dt.toString(QStringLiteral("h:m:s ap"))
+                          << NoError;
+  QTest::newRow("time01") << "{{ d|time:\"H:mm 'h'\" }}" << dict
+                          << dt.toString(QStringLiteral("H:mm 'h'"))
+                          << NoError;
+
   dict.clear();
   dict.insert(QStringLiteral("d"), QStringLiteral("fail_string"));
   QTest::newRow("date03") << "{{ d|date:\"MM\" }}" << dict << QString()
                           << NoError;
 }
 
+void TestFilters::benchmarkDateFilter()
+{
+  auto t = m_engine->newTemplate(
+      QStringLiteral("{% for d in dates %}{{ d|date }} {{ d|date:\"dd/MM/yyyy "
+                     "hh:mm\" }}{% endfor %}"),
+      QStringLiteral("benchmarkDateFilter"));
+
+  QVariantList dates;
+  const QDateTime start(QDate(2020, 1, 1), QTime(9, 30));
+  for (auto i = 0; i < 1000; ++i)
+    dates.append(start.addSecs(i * 3607));
+  Context c;
+  c.insert(QStringLiteral("dates"), dates);
+
+  QBENCHMARK { t->render(&c); }
+  QCOMPARE(t->error(), NoError);
+}
+
+void TestFilters::benchmarkStringFilters_data()
+{
+  QTest::addColumn<QString>("filter");
+
+  for (const auto &filter :
+       {"escapejs", "fix_ampersands", "linebreaks", "removetags:\"b i\"",
+        "slugify", "striptags", "truncatewords:500", "wordwrap:72",
+        "lower|escape|linebreaksbr|truncatechars:50000", "linebreaksbr",
+        "escape"})
+    QTest::newRow(filter) << QString::fromLatin1(filter);
+}
+
+void TestFilters::benchmarkStringFilters()
+{
+  QFETCH(QString, filter);
+
+  auto t = m_engine->newTemplate(
+      QStringLiteral("{% autoescape off %}{{ text|%1 }}{% endautoescape %}")
+          .arg(filter),
+      QStringLiteral("benchmarkStringFilters"));
+  QCOMPARE(t->error(), NoError);
+
+  QString text;
+  for (auto i = 0; i < 1000; ++i)
+    text += QStringLiteral("Some <b>user</b> text & more, with a "
+                           "<i class=\"x\">tag</i>;\nand a line.\n\n");
+  Context c;
+  c.insert(QStringLiteral("text"), text);
+
+  QBENCHMARK { t->render(&c); }
+}
+
 void TestFilters::testStringFilters_data()
 {
   QTest::addColumn<QString>("input");
@@ -986,6 +1058,41 @@ void TestFilters::testStringFilters_data()
                         "}}{% endautoescape %}")
       << dict << QStringLiteral("x y x y") << NoError;
 
+  dict.clear();
+  dict.insert(QStringLiteral("a"),
+              QStringLiteral("<b class=\"x\">bold</b><br/><bx>no</bx></ b>"));
+  dict.insert(QStringLiteral("b"), QStringLiteral("a<b<c>d>e<f"));
+  dict.insert(QStringLiteral("c"),
+              QStringLiteral("&amp; &#38; &#x26; &foo &; & a&b_c;"));
+  dict.insert(QStringLiteral("d"), QStringLiteral(" -Hello,  World - "));
+  dict.insert(QStringLiteral("e"), QStringLiteral("  a  b   c "));
+  dict.insert(QStringLiteral("f"), QStringLiteral("a\n\n\nb\nc\n\n"));
+
+  QTest::newRow("filter-removetags03")
+      << R"({% autoescape off %}{{ a|removetags:"b br" }}{% endautoescape %})"
+      << dict << QStringLiteral("bold<bx>no</bx></ b>") << NoError;
+  QTest::newRow("filter-striptags03")
+      << QStringLiteral(
+             "{% autoescape off %}{{ b|striptags }}{% endautoescape %}")
+      << dict << QStringLiteral("ad>e<f") << NoError;
+  QTest::newRow("filter-fix_ampersands03")
+      << QStringLiteral(
+             "{% autoescape off %}{{ c|fix_ampersands }}{% endautoescape %}")
+      << dict
+      << QStringLiteral("&amp; &#38; &amp;#x26; &amp;foo &amp;; &amp; a&b_c;")
+      << NoError;
+  QTest::newRow("filter-slugify04")
+      << QStringLiteral("{{ d|slugify }}") << dict
+      << QStringLiteral("-hello-world-") << NoError;
+  QTest::newRow("filter-truncatewords03")
+      << QStringLiteral("{{ e|truncatewords:2 }}") << dict
+      << QStringLiteral("a b ...") << NoError;
+  QTest::newRow("filter-linebreaks03")
+      << QStringLiteral(
+             "{% autoescape off %}{{ f|linebreaks }}{% endautoescape %}")
+      << dict << QStringLiteral("<p>a</p>\n\n<p>b<br />c</p>\n\n<p></p>")
+      << NoError;
+
   dict.clear();
   dict.insert(QStringLiteral("fs_int_mib"), 1048576);
 
@@ -1590,6 +1697,36 @@ void TestFilters::testMiscFilters_data()
       "{% autoescape off %}{{ a|safe|force_escape }}{% endautoescape %}")
                               << dict << QStringLiteral("a &lt; b") << NoError;
 
+  //  Chains of filters run on one string keep the safety of each step.
+
+  dict.clear();
+  dict.insert(QStringLiteral("a"), QStringLiteral("A < B\nC"));
+  dict.insert(QStringLiteral("b"),
+              QVariant::fromValue(markSafe(QStringLiteral("a < b"))));
+  dict.insert(QStringLiteral("n"), 42);
+
+  QTest::newRow("chaining15")
+      << QStringLiteral("{{ a|lower|escape|linebreaksbr|truncatechars:8 }}")
+      << dict << QStringLiteral("a &lt; b...") << NoError;
+  QTest::newRow("chaining16")
+      << QStringLiteral("{% autoescape off %}{{ "
+                        "a|lower|escape|linebreaksbr|truncatechars:8 }}{% "
+                        "endautoescape %}")
+      << dict << QStringLiteral("a < b<br...") << NoError;
+  QTest::newRow("chaining17")
+      << R"({{ b|lower|upper }}.{{ n|cut:"2"|upper }})" << dict
+      << QStringLiteral("A &lt; B.4") << NoError;
+
+  //  The last filter writes its result to the stream directly.
+
+  QTest::newRow("chaining18")
+      << QStringLiteral("{{ a|escape|linebreaksbr }}.{{ b|safe }}") << dict
+      << QStringLiteral("A &lt; B<br />C.a < b") << NoError;
+  QTest::newRow("chaining19")
+      << QStringLiteral("{% autoescape off %}{{ a|linebreaksbr|escape }}.{{ "
+                        "a|force_escape }}{% endautoescape %}")
+      << dict << QStringLiteral("A < B<br />C.A &lt; B\nC") << NoError;
+
   //   //  Filters decorated with stringfilter still respect is_safe.
   //
   //   //  {"unsafe": UnsafeClass()
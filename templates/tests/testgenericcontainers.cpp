@@ -42,6 +42,9 @@ public:
 
 private Q_SLOTS:
   void testContainer_Builtins();
+  void testContainer_Filters();
+
+  void benchmarkContainer_Filters();
 };
 
 TestGenericContainers::TestGenericContainers(QObject *parent)
@@ -362,5 +365,48 @@ void TestGenericContainers::testContainer_Builtins()
 #endif
 }
 
+template <typename Container> void doTestContainerFilters()
+{
+  Container container;
+  ContainerPopulator<Container>::populateSequential(container);
+
+  testContainer(
+      QStringLiteral("{{ container|first }};{{ container|last }};{{ "
+                     "container|length }};{{ container|join:\"-\" }};{% if 7 "
+                     "in container %}in{% endif %};{% if 8 not in container "
+                     "%}not in{% endif %};"),
+      QVariant::fromValue(container),
+      {QStringLiteral("9;5;3;9-7-5;in;not in;")}, false);
+}
+
+void TestGenericContainers::testContainer_Filters()
+{
+  doTestContainerFilters<QVector<qint32>>();
+  doTestContainerFilters<QList<qint32>>();
+  doTestContainerFilters<std::list<qint32>>();
+}
+
+void TestGenericContainers::benchmarkContainer_Filters()
+{
+  Grantlee::Engine engine;
+
+  engine.setPluginPaths({QStringLiteral(GRANTLEE_PLUGIN_PATH)});
+
+  QVector<qint32> container;
+  for (auto i = 0; i < 100000; ++i)
+    container.push_back(i);
+
+  Grantlee::Context c;
+  c.insert(QStringLiteral("container"), QVariant::fromValue(container));
+
+  auto t = engine.newTemplate(
+      QStringLiteral("{{ container|first }};{{ container|last }};{{ "
+                     "container|length }};{% if 99999 in container %}in{% "
+                     "endif %};{% for item in container %}{% endfor %}"),
+      QStringLiteral("benchmark"));
+
+  QBENCHMARK { t->render(&c); }
+}
+
 QTEST_MAIN(TestGenericContainers)
 #include "testgenericcontainers.moc"
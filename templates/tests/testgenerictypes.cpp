@@ -28,6 +28,7 @@
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
 #include <QtCore/QLinkedList>
 #endif
+#include <QtCore/QAbstractListModel>
 #include <QtCore/QMetaType>
 #include <QtCore/QQueue>
 #include <QtCore/QStack>
@@ -58,6 +59,7 @@ private Q_SLOTS:
   void initTestCase();
 
   void testGenericClassType();
+  void testLookupTable();
   void testSequentialContainer_Variant();
   void testAssociativeContainer_Variant();
   void testSequentialContainer_Type();
@@ -75,6 +77,10 @@ private Q_SLOTS:
   void testQGadget();
   void testGadgetMetaType();
 
+  void testItemModel();
+
+  void benchmarkLookup();
+
 }; // class TestGenericTypes
 
 class Person
@@ -120,6 +126,22 @@ if (property == QStringLiteral("age"))
   return object.m_age;
 GRANTLEE_END_LOOKUP
 
+struct Address {
+  QString street;
+  QString city;
+  QString country;
+  int number;
+};
+
+Q_DECLARE_METATYPE(Address)
+
+GRANTLEE_BEGIN_LOOKUP_TABLE(Address)
+{"street", [](const Address &address) -> QVariant { return address.street; }},
+{"city", [](const Address &address) -> QVariant { return address.city; }},
+{"country", [](const Address &address) -> QVariant { return address.country; }},
+{"number", [](const Address &address) -> QVariant { return address.number; }},
+GRANTLEE_END_LOOKUP_TABLE
+
 class PersonObject : public QObject
 {
   Q_OBJECT
@@ -144,6 +166,7 @@ void TestGenericTypes::initTestCase()
   // Register the handler for our custom type
   Grantlee::registerMetaType<Person>();
   Grantlee::registerMetaType<PersonGadget>();
+  Grantlee::registerMetaType<Address>();
 }
 
 void TestGenericTypes::testGenericClassType()
@@ -166,6 +189,25 @@ void TestGenericTypes::testGenericClassType()
            QStringLiteral("Person: \nName: Grant Lee\nAge: 2\nUnknown: "));
 }
 
+void TestGenericTypes::testLookupTable()
+{
+  Grantlee::Engine engine;
+
+  engine.setPluginPaths({QStringLiteral(GRANTLEE_PLUGIN_PATH)});
+
+  auto t1 = engine.newTemplate(
+      QStringLiteral("{{ a.number }} {{ a.street }}, {{ a.city }}, {{ "
+                     "a.country }}.{{ a.town }}{{ a.countries }}{{ a.c }}"),
+      QStringLiteral("template1"));
+
+  Address a{QStringLiteral("Main Street"), QStringLiteral("Springfield"),
+            QStringLiteral("Nowhere"), 742};
+  Grantlee::Context c;
+  c.insert(QStringLiteral("a"), QVariant::fromValue(a));
+  QCOMPARE(t1->render(&c),
+           QStringLiteral("742 Main Street, Springfield, Nowhere."));
+}
+
 static QMap<int, Person> getPeople()
 {
   QMap<int, Person> people;
@@ -935,5 +977,175 @@ void TestGenericTypes::propertyMacroTypes()
   }
 }
 
+class BookModel : public QAbstractListModel
+{
+  Q_OBJECT
+public:
+  enum Roles { TitleRole = Qt::UserRole + 1, AuthorRole };
+
+  BookModel(int count, int batchSize, QObject *parent = {})
+      : QAbstractListModel(parent), m_count(count), m_batchSize(batchSize),
+        m_fetched(0)
+  {
+  }
+
+  int rowCount(const QModelIndex &parent = {}) const override
+  {
+    return parent.isValid() ? 0 : m_fetched;
+  }
+
+  QVariant data(const QModelIndex &index, int role) const override
+  {
+    if (role == TitleRole || role == Qt::DisplayRole)
+      return QStringLiteral("Book %1").arg(index.row());
+    if (role == AuthorRole)
+      return QStringLiteral("Author %1").arg(index.row() % 3);
+    return {};
+  }
+
+  QHash<int, QByteArray> roleNames() const override
+  {
+    auto names = QAbstractListModel::roleNames();
+    names.insert(TitleRole, "title");
+    names.insert(AuthorRole, "author");
+    return names;
+  }
+
+  bool canFetchMore(const QModelIndex &parent) const override
+  {
+    return !parent.isValid() && m_fetched < m_count;
+  }
+
+  void fetchMore(const QModelIndex &parent) override
+  {
+    const auto more = qMin(m_batchSize, m_count - m_fetched);
+    beginInsertRows(parent, m_fetched, m_fetched + more - 1);
+    m_fetched += more;
+    endInsertRows();
+  }
+
+private:
+  const int m_count;
+  const int m_batchSize;
+  int m_fetched;
+};
+
+void TestGenericTypes::testItemModel()
+{
+  Grantlee::Engine engine;
+
+  engine.setPluginPaths({QStringLiteral(GRANTLEE_PLUGIN_PATH)});
+
+  BookModel model(5, 2);
+
+  Grantlee::Context c;
+  c.insert(QStringLiteral("books"), &model);
+
+  {
+    auto t1 = engine.newTemplate(
+        QStringLiteral("{{ books.1.title }}--{{ books.1.0.display }}"),
+        QStringLiteral("template1"));
+
+    QCOMPARE(t1->render(&c), QStringLiteral("Book 1--Book 1"));
+    // Only the rows which were looked up have been fetched.
+    QCOMPARE(model.rowCount(), 2);
+  }
+
+  {
+    auto t1 = engine.newTemplate(
+        QStringLiteral("{{ books.count }};{% for book in books %}{{ book.row "
+                       "}}:{{ book.title }} by {{ book.author }},{% endfor %}"),
+        QStringLiteral("template1"));
+
+    QCOMPARE(t1->render(&c),
+             QStringLiteral("5;0:Book 0 by Author 0,1:Book 1 by Author 1,"
+                            "2:Book 2 by Author 2,3:Book 3 by Author 0,"
+                            "4:Book 4 by Author 1,"));
+  }
+
+  {
+    auto t1 = engine.newTemplate(
+        QStringLiteral("{{ books.5.title }}-{{ books.0.parent }}-{{ "
+                       "books.0.children.count }}"),
+        QStringLiteral("template1"));
+
+    QCOMPARE(t1->render(&c), QStringLiteral("--0"));
+  }
+
+  {
+    // The loop fetches one row ahead of the row being rendered.
+    BookModel lazyModel(7, 2);
+    Grantlee::Context lazyContext;
+    lazyContext.insert(QStringLiteral("books"), &lazyModel);
+    lazyContext.insertLazy(QStringLiteral("fetched"),
+                           [&lazyModel] { return lazyModel.rowCount(); });
+
+    auto t1 = engine.newTemplate(
+        QStringLiteral("{% for book in books %}{% if forloop.counter == 3 %}{{ "
+                       "fetched }};{% endif %}{{ book.row }},{% endfor %}"),
+        QStringLiteral("template1"));
+
+    QCOMPARE(t1->render(&lazyContext), QStringLiteral("0,1,4;2,3,4,5,6,"));
+    QCOMPARE(lazyModel.rowCount(), 7);
+  }
+
+  {
+    // All rows are fetched once the reverse counter is used.
+    BookModel lazyModel(7, 2);
+    Grantlee::Context lazyContext;
+    lazyContext.insert(QStringLiteral("books"), &lazyModel);
+    lazyContext.insertLazy(QStringLiteral("fetched"),
+                           [&lazyModel] { return lazyModel.rowCount(); });
+
+    auto t1 = engine.newTemplate(
+        QStringLiteral("{% for book in books %}{% if forloop.first %}{{ "
+                       "forloop.revcounter }}:{{ fetched }};{% endif %}{{ "
+                       "forloop.revcounter0 }},{% endfor %}"),
+        QStringLiteral("template1"));
+
+    QCOMPARE(t1->render(&lazyContext), QStringLiteral("7:7;6,5,4,3,2,1,0,"));
+  }
+
+  {
+    BookModel emptyModel(0, 2);
+    c.insert(QStringLiteral("books"), &emptyModel);
+
+    auto t1 = engine.newTemplate(
+        QStringLiteral("{% for book in books %}{{ book.row }}{% empty "
+                       "%}none{% endfor %}"),
+        QStringLiteral("template1"));
+
+    QCOMPARE(t1->render(&c), QStringLiteral("none"));
+  }
+}
+
+void TestGenericTypes::benchmarkLookup()
+{
+  Grantlee::Engine engine;
+
+  engine.setPluginPaths({QStringLiteral(GRANTLEE_PLUGIN_PATH)});
+
+  Grantlee::Context c;
+  c.insert(QStringLiteral("person"),
+           QVariant::fromValue(Person("Grant Lee", 2)));
+  PersonGadget gadget;
+  gadget.m_name = QStringLiteral("Smith");
+  c.insert(QStringLiteral("gadget"), QVariant::fromValue(gadget));
+  c.insert(QStringLiteral("list"), QVariantList{1, 2, 3});
+  c.insert(QStringLiteral("hash"),
+           QVariantHash{{QStringLiteral("key"), QStringLiteral("value")}});
+
+  auto t = engine.newTemplate(
+      QStringLiteral("{% for i in list %}{{ person.name }}{{ person.age }}{{ "
+                     "gadget.name }}{{ gadget.age }}{{ list.1 }}{{ list.size "
+                     "}}{{ hash.key }}{{ hash.size }}{% endfor %}"),
+      QStringLiteral("benchmark"));
+
+  QCOMPARE(t->render(&c),
+           QStringLiteral("Grant Lee2Smith4223value1").repeated(3));
+
+  QBENCHMARK { t->render(&c); }
+}
+
 QTEST_MAIN(TestGenericTypes)
 #include "testgenerictypes.moc"
@@ -29,6 +29,8 @@
 #include <QtCore/QTranslator>
 #include <QtTest/QTest>
 
+#include <limits>
+
 using namespace Grantlee;
 
 #if QT_VERSION < QT_VERSION_CHECK(5, 12, 0)
@@ -96,6 +98,11 @@ private Q_SLOTS:
   void testLocalizedTemplate();
   void testSafeContent();
   void testFailure();
+  void testTranslationInvalidation();
+  void testArgumentSubstitution();
+  void testGroupedIntegers();
+
+  void benchmarkLocalizedFormatting();
 
   void testStrings_data();
   void testIntegers_data();
@@ -106,6 +113,7 @@ private Q_SLOTS:
   void testLocalizedTemplate_data();
   void testSafeContent_data();
   void testFailure_data();
+  void testArgumentSubstitution_data();
 
 private:
   QSharedPointer<QtLocalizer> cLocalizer;
@@ -1009,6 +1017,111 @@ void TestInternationalization::testFailure_data()
       "visited today' %}");
 }
 
+void TestInternationalization::testTranslationInvalidation()
+{
+  QtLocalizer localizer(QLocale(QLocale::German, QLocale::Germany));
+  QTranslator emptyTranslator;
+  localizer.installTranslator(&emptyTranslator, QStringLiteral("de_DE"));
+
+  QCOMPARE(localizer.localizeString(QStringLiteral("Birthday")),
+           QStringLiteral("Birthday"));
+  QCOMPARE(localizer.localizePluralString(QStringLiteral("%n People"), {},
+                                          {QVariant(2)}),
+           QStringLiteral("2 People"));
+
+  QTranslator deTranslator;
+  QVERIFY(deTranslator.load(QStringLiteral(":/test_de_DE")));
+  localizer.installTranslator(&deTranslator, QStringLiteral("de_DE"));
+
+  QCOMPARE(localizer.localizeString(QStringLiteral("Birthday")),
+           QStringLiteral("Geburtstag"));
+  QCOMPARE(localizer.localizePluralString(QStringLiteral("%n People"), {},
+                                          {QVariant(1)}),
+           QStringLiteral("1 Person"));
+  QCOMPARE(localizer.localizePluralString(QStringLiteral("%n People"), {},
+                                          {QVariant(2)}),
+           QStringLiteral("2 Personen"));
+  QCOMPARE(localizer.localizePluralString(QStringLiteral("%n People"), {},
+                                          {QVariant(1)}),
+           QStringLiteral("1 Person"));
+}
+
+void TestInternationalization::testArgumentSubstitution()
+{
+  QFETCH(QString, input);
+  QFETCH(QVariantList, args);
+
+  // The arguments are substituted as by successive calls to QString::arg.
+  auto expected = input;
+  for (const auto &arg : qAsConst(args)) {
+    if (arg.userType() == qMetaTypeId<int>())
+      expected = expected.arg(arg.toInt());
+    else
+      expected = expected.arg(arg.toString());
+  }
+
+  QCOMPARE(deLocalizer->localizeString(input, args), expected);
+  QCOMPARE(deLocalizer->localizeString(input, args), expected);
+  QCOMPARE(cLocalizer->localizeString(input, args), expected);
+}
+
+void TestInternationalization::testArgumentSubstitution_data()
+{
+  QTest::addColumn<QString>("input");
+  QTest::addColumn<QVariantList>("args");
+
+  const QVariantList args{QStringLiteral("a"), 1000};
+
+  QTest::newRow("args-01") << QStringLiteral("%1 and %2") << args;
+  QTest::newRow("args-02") << QStringLiteral("%2 before %1") << args;
+  QTest::newRow("args-03") << QStringLiteral("%1 %1 %L2 %2") << args;
+  QTest::newRow("args-04") << QStringLiteral("%1%2") << args;
+  QTest::newRow("args-05") << QStringLiteral("%2%1") << QVariantList{3, 4};
+  QTest::newRow("args-06") << QStringLiteral("100%%1") << QVariantList{5, 6};
+  QTest::newRow("args-07") << QStringLiteral("%7 and %3") << args;
+  QTest::newRow("args-08") << QStringLiteral("%1 and %2") << QVariantList{1};
+  QTest::newRow("args-09") << QStringLiteral("%1") << args;
+  QTest::newRow("args-10") << QStringLiteral("%1 and %2")
+                           << QVariantList{QStringLiteral("%2"), 1};
+  QTest::newRow("args-11") << QStringLiteral("%12% %1") << args;
+  QTest::newRow("args-12") << QStringLiteral("No escapes") << args;
+}
+
+void TestInternationalization::testGroupedIntegers()
+{
+  const QList<QSharedPointer<QtLocalizer>> localizers{
+      cLocalizer, deLocalizer, frLocalizer, en_GBLocalizer, en_USLocalizer};
+  const int numbers[] = {0,       -3,         999,         1000,
+                         -10000,  123456,     -1234567,    20000000,
+                         std::numeric_limits<int>::max(),
+                         std::numeric_limits<int>::min()};
+  for (const auto &localizer : localizers) {
+    const QLocale locale(localizer->currentLocale());
+    for (const auto number : numbers) {
+      auto expected = locale.toString(number);
+      if (localizer == cLocalizer)
+        expected.remove(QLocale::c().groupSeparator());
+      QCOMPARE(localizer->localizeNumber(number), expected);
+    }
+  }
+}
+
+void TestInternationalization::benchmarkLocalizedFormatting()
+{
+  const QDate date(2005, 5, 7);
+  QString result;
+  QBENCHMARK
+  {
+    for (auto i = 0; i < 1000; ++i) {
+      result = deLocalizer->localizeNumber(i * 1013);
+      result = deLocalizer->localizeDate(date);
+      result = en_USLocalizer->localizeMonetaryValue(i * 1.5,
+                                                     QStringLiteral("USD"));
+    }
+  }
+  QVERIFY(!result.isEmpty());
+}
+
 void TestInternationalization::testDates()
 {
   QFETCH(QDate, date);
@@ -23,12 +23,16 @@
 
 #include <QtCore/QDebug>
 #include <QtCore/QDir>
+#include <QtCore/QFile>
 #include <QtCore/QFileInfo>
+#include <QtCore/QTemporaryDir>
+#include <QtCore/QThreadPool>
 #include <QtTest/QTest>
 
 #include "context.h"
 #include "coverageobject.h"
 #include "engine.h"
+#include "fragmentcache.h"
 #include "grantlee_paths.h"
 #include "template.h"
 
@@ -60,6 +64,13 @@ private Q_SLOTS:
   void testBlockTagErrors_data();
   void testBlockTagErrors() { doTest(); }
 
+  void testCacheTag();
+  void testFileSystemFragmentCache();
+
+  void testTemplateReloading();
+
+  void testRenderBatch();
+
 private:
   void doTest();
 
@@ -122,6 +133,207 @@ void TestLoaderTags::testTemplateFromQrc()
   QCOMPARE(result, QStringLiteral("one-two-three-four\n\n"));
 }
 
+void TestLoaderTags::testRenderBatch()
+{
+  Engine engine;
+  engine.setPluginPaths({QStringLiteral(GRANTLEE_PLUGIN_PATH)});
+
+  auto loader = QSharedPointer<InMemoryTemplateLoader>::create();
+  loader->setTemplate(QStringLiteral("base"),
+                      QStringLiteral("{% block content %}base {{ name }}{% "
+                                     "block inner %}[{{ name }}]{% endblock "
+                                     "%}{% endblock %}"));
+  engine.addTemplateLoader(loader);
+
+  auto t = engine.newTemplate(
+      QStringLiteral("{% extends \"base\" %}{% block content %}{{ block.super "
+                     "}}|{% block inner %}{{ block.super }}{{ name }}{% "
+                     "endblock %}{% endblock %}"),
+      QStringLiteral("child"));
+  QCOMPARE(t->error(), NoError);
+
+  QThreadPool pool;
+  pool.setMaxThreadCount(4);
+
+  QList<Context *> contexts;
+  QStringList expected;
+  for (auto i = 0; i < 200; ++i) {
+    auto c = new Context;
+    const auto name = QStringLiteral("name%1").arg(i);
+    c->insert(QStringLiteral("name"), name);
+    contexts.append(c);
+    expected.append(QStringLiteral("base %1[%1]%1|[%1]%1").arg(name));
+  }
+
+  QCOMPARE(t->renderBatch(contexts, &pool), expected);
+  QCOMPARE(t->error(), NoError);
+
+  // Blocks of a template which does not extend another one.
+  t = engine.loadByName(QStringLiteral("base"));
+  expected.clear();
+  for (auto c : contexts)
+    expected.append(QStringLiteral("base %1[%1]")
+                        .arg(c->lookup(QStringLiteral("name")).toString()));
+  QCOMPARE(t->renderBatch(contexts, &pool), expected);
+
+  qDeleteAll(contexts);
+}
+
+void TestLoaderTags::testCacheTag()
+{
+  Engine engine;
+  engine.setPluginPaths({QStringLiteral(GRANTLEE_PLUGIN_PATH)});
+
+  auto t = engine.newTemplate(
+      QStringLiteral("{% cache timeout sidebar user %}{{ value }}{% endcache %}"),
+      QStringLiteral("cache"));
+  QCOMPARE(t->error(), NoError);
+
+  Context c;
+  c.insert(QStringLiteral("timeout"), 60);
+  c.insert(QStringLiteral("user"), QStringLiteral("alice"));
+  c.insert(QStringLiteral("value"), 1);
+
+  // Without a fragment cache the content is always rendered.
+  QCOMPARE(t->render(&c), QStringLiteral("1"));
+  c.insert(QStringLiteral("value"), 2);
+  QCOMPARE(t->render(&c), QStringLiteral("2"));
+
+  auto cache = QSharedPointer<InMemoryFragmentCache>::create();
+  engine.setFragmentCache(cache);
+
+  QCOMPARE(t->render(&c), QStringLiteral("2"));
+  c.insert(QStringLiteral("value"), 3);
+  QCOMPARE(t->render(&c), QStringLiteral("2"));
+  c.insert(QStringLiteral("user"), QStringLiteral("bob"));
+  QCOMPARE(t->render(&c), QStringLiteral("3"));
+
+  QCOMPARE(cache->hits(), quint64(1));
+  QCOMPARE(cache->misses(), quint64(2));
+  QCOMPARE(cache->size(), 2);
+
+  cache->clear();
+  c.insert(QStringLiteral("value"), 4);
+  QCOMPARE(t->render(&c), QStringLiteral("4"));
+
+  // A timeout of 0 does not cache, and a negative one caches without expiry.
+  cache->clear();
+  cache->resetStatistics();
+  c.insert(QStringLiteral("timeout"), 0);
+  QCOMPARE(t->render(&c), QStringLiteral("4"));
+  c.insert(QStringLiteral("value"), 5);
+  QCOMPARE(t->render(&c), QStringLiteral("5"));
+  QCOMPARE(cache->size(), 0);
+  QCOMPARE(cache->misses(), quint64(0));
+
+  c.insert(QStringLiteral("timeout"), -1);
+  QCOMPARE(t->render(&c), QStringLiteral("5"));
+  c.insert(QStringLiteral("value"), 6);
+  QCOMPARE(t->render(&c), QStringLiteral("5"));
+  QCOMPARE(cache->size(), 1);
+  cache->clear();
+
+  c.insert(QStringLiteral("timeout"), QStringLiteral("soon"));
+  t->render(&c);
+  QCOMPARE(t->error(), TagSyntaxError);
+
+  t = engine.newTemplate(QStringLiteral("{% cache 60 %}{% endcache %}"),
+                         QStringLiteral("cache-error"));
+  QCOMPARE(t->error(), TagSyntaxError);
+}
+
+void TestLoaderTags::testFileSystemFragmentCache()
+{
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+
+  FileSystemFragmentCache cache(dir.path() + QStringLiteral("/fragments"));
+
+  QString fragment;
+  QVERIFY(!cache.lookup(QStringLiteral("key"), &fragment));
+
+  cache.insert(QStringLiteral("key"), QStringLiteral("<b>fragment</b>"), 0);
+  QVERIFY(!cache.lookup(QStringLiteral("key"), &fragment));
+  cache.resetStatistics();
+
+  cache.insert(QStringLiteral("key"), QStringLiteral("<b>fragment</b>"), -1);
+  QVERIFY(cache.lookup(QStringLiteral("key"), &fragment));
+  QCOMPARE(fragment, QStringLiteral("<b>fragment</b>"));
+
+  // Another cache on the same directory sees the fragment too.
+  FileSystemFragmentCache other(cache.directory());
+  QVERIFY(other.lookup(QStringLiteral("key"), &fragment));
+
+  QCOMPARE(cache.hits(), quint64(1));
+  QCOMPARE(cache.misses(), quint64(1));
+  cache.resetStatistics();
+  QCOMPARE(cache.hits(), quint64(0));
+
+  cache.clear();
+  QVERIFY(!cache.lookup(QStringLiteral("key"), &fragment));
+}
+
+static void writeFile(const QString &path, const QString &content)
+{
+  QFile file(path);
+  QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+  file.write(content.toUtf8());
+}
+
+void TestLoaderTags::testTemplateReloading()
+{
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  writeFile(dir.filePath(QStringLiteral("page.html")),
+            QStringLiteral("{% include 'part.html' %}!"));
+  writeFile(dir.filePath(QStringLiteral("part.html")), QStringLiteral("one"));
+
+  Engine engine;
+  engine.setPluginPaths({QStringLiteral(GRANTLEE_PLUGIN_PATH)});
+  auto loader = QSharedPointer<FileSystemTemplateLoader>::create();
+  loader->setTemplateDirs({dir.path()});
+  engine.addTemplateLoader(loader);
+  auto memoryLoader = QSharedPointer<InMemoryTemplateLoader>::create();
+  memoryLoader->setTemplate(QStringLiteral("memory.html"),
+                            QStringLiteral("{% include 'part.html' %}?"));
+  engine.addTemplateLoader(memoryLoader);
+  engine.setTemplateReloadingEnabled(true, 60 * 60 * 1000);
+  QVERIFY(engine.templateReloadingEnabled());
+
+  Context c;
+  auto t = engine.loadByName(QStringLiteral("page.html"));
+  QCOMPARE(t->render(&c), QStringLiteral("one!"));
+  QCOMPARE(engine.loadByName(QStringLiteral("page.html")), t);
+
+  engine.reloadChangedTemplates();
+  QCOMPARE(engine.templateGeneration(), 0);
+
+  writeFile(dir.filePath(QStringLiteral("part.html")),
+            QStringLiteral("two and more"));
+  engine.reloadChangedTemplates();
+  QCOMPARE(engine.templateGeneration(), 1);
+
+  // The including template is unchanged, and includes the new part.
+  QCOMPARE(engine.loadByName(QStringLiteral("page.html")), t);
+  QCOMPARE(t->render(&c), QStringLiteral("two and more!"));
+
+  // Templates without a source file are compiled once.
+  auto memory = engine.loadByName(QStringLiteral("memory.html"));
+  QCOMPARE(memory->render(&c), QStringLiteral("two and more?"));
+  QCOMPARE(engine.loadByName(QStringLiteral("memory.html")), memory);
+
+  // The timer reloads the changed templates on another thread.
+  engine.setTemplateReloadingEnabled(true, 10);
+  writeFile(dir.filePath(QStringLiteral("part.html")), QStringLiteral("three"));
+  QTRY_COMPARE(engine.templateGeneration(), 2);
+  QCOMPARE(t->render(&c), QStringLiteral("three!"));
+  QCOMPARE(engine.loadByName(QStringLiteral("memory.html")), memory);
+  QCOMPARE(memory->render(&c), QStringLiteral("three?"));
+
+  engine.setTemplateReloadingEnabled(false);
+  QVERIFY(!engine.templateReloadingEnabled());
+}
+
 void TestLoaderTags::doTest()
 {
   QFETCH(QString, input);